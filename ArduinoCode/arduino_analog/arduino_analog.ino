@@ -4,6 +4,7 @@
 #include <SPI.h>
 #include <Adafruit_LIS3DH.h>
 #include <Adafruit_Sensor.h>
+#include "sensor_frame.h"
 
 const int PulseWire = 0;       // PulseSensor PURPLE WIRE connected to ANALOG PIN 0
 const int LED13 = 13;          // The on-board Arduino LED, close to PIN 13.
@@ -27,6 +28,17 @@ static int Threshold = 550;           // Determine which Signal to "count as a b
 // For debugging mode uncomment this line
 //#define DEBUG (1)
 
+// Send COBS framed binary (see sensor_frame.h) instead of ASCII lines.
+// The host detects the format on its own.
+//#define USE_BINARY_FRAMES (1)
+
+#ifdef USE_BINARY_FRAMES
+#define SERIAL_BAUD (115200)
+SensorFrame frame;
+#else
+#define SERIAL_BAUD (9600)
+#endif
+
 PulseSensorPlayground pulseSensor;  // Creates an instance of the PulseSensorPlayground object called "pulseSensor"
 
 // I2C
@@ -34,8 +46,8 @@ Adafruit_LIS3DH lis = Adafruit_LIS3DH();
 
 // the setup routine runs once when you press reset:
 void setup() {
-  // initialize serial communication at 9600 bits per second:
-  Serial.begin(9600);
+  // initialize serial communication at SERIAL_BAUD bits per second:
+  Serial.begin(SERIAL_BAUD);
   //while (!Serial) delay(10);     // will pause Zero, Leonardo, etc until serial console opens
 
   //Serial.println("LIS3DH test!");
@@ -66,10 +78,12 @@ void setup() {
 
 #ifndef DEBUG
 void loop() {
+  begin_report();
   //rw_temp1(); // burns if used...
   rw_temp2();
   rw_pulse();
   rw_accl();
+  end_report();
 }
 #else
 void loop() {
@@ -80,6 +94,36 @@ void loop() {
 }
 #endif // DEBUG
 
+// Every reading goes through report(), which either prints the classic
+// "<id><value>" line or adds the reading to this loop's binary frame.
+void begin_report() {
+#ifdef USE_BINARY_FRAMES
+  sensorFrameBegin(&frame, millis());
+#endif
+}
+
+void end_report() {
+#ifdef USE_BINARY_FRAMES
+  if (frame.count > 0) {
+    uint8_t encoded[SENSOR_FRAME_MAX_ENCODED];
+    Serial.write(encoded, sensorFrameEncode(&frame, encoded));
+  }
+#endif
+}
+
+void report(uint8_t id, float value) {
+#ifdef USE_BINARY_FRAMES
+  if (!sensorFrameAdd(&frame, id, value)) {
+    end_report();
+    begin_report();
+    sensorFrameAdd(&frame, id, value);
+  }
+#else
+  Serial.print(id);
+  Serial.println(value);
+#endif
+}
+
 void rw_temp1() {
 //Temperature Sensor 1:
   int sensorValue = analogRead(PIN_TEMP1);   // read the input on analog pin 0:
@@ -88,8 +132,7 @@ void rw_temp1() {
   float voltage = sensorValue * (5 / 1023.0);
   float temp = ((voltage*1000)-500) / 10; // Celsius
   
-  Serial.print(TEMP1);
-  Serial.println(temp);
+  report(TEMP1, temp);
   return;
 }
 
@@ -102,8 +145,7 @@ void rw_temp2() {
   float temp = ((voltage*1000)-500) / 10; // Celsius
   
   // print out the value you read:
-  Serial.print(TEMP2);
-  Serial.println(temp);
+  report(TEMP2, temp);
   return;
 }
 
@@ -113,8 +155,7 @@ void rw_pulse() {
 
   if (pulseSensor.sawStartOfBeat()) {            // Constantly test to see if "a beat happened". 
    //Serial.println("----------------");
-   Serial.print(PULSE);                        // Print phrase "BPM: " 
-   Serial.println(myBPM);                        // Print the value inside of myBPM. 
+   report(PULSE, myBPM);                         // Send the value inside of myBPM.
    //Serial.println("------------------");
   }
 
@@ -126,13 +167,10 @@ void rw_accl() {
   sensors_event_t event;
   lis.getEvent(&event);
 
-  /* Display the results (acceleration is measured in m/s^2) */
-  Serial.print(ACCLX); 
-  Serial.println(event.acceleration.x);
-  Serial.print(ACCLY); 
-  Serial.println(event.acceleration.y);
-  Serial.print(ACCLZ);
-  Serial.println(event.acceleration.z);
+  /* Send the results (acceleration is measured in m/s^2) */
+  report(ACCLX, event.acceleration.x);
+  report(ACCLY, event.acceleration.y);
+  report(ACCLZ, event.acceleration.z);
 }
 
 void rw_accl_debug() {
@@ -0,0 +1,267 @@
+// sensor_frame.h
+// Binary framed wire protocol between arduino_analog.ino and the JUCE host.
+//
+// Plain C++ with no Arduino or JUCE dependencies so the same encoder/decoder
+// builds for the board, for the host and for a desktop round-trip check.
+//
+// One frame carries every reading taken in one loop() pass:
+//
+//   offset  size  field
+//   0       1     version (SENSOR_FRAME_VERSION)
+//   1       1     record count n (1..SENSOR_FRAME_MAX_RECORDS)
+//   2       4     device timestamp, millis(), little endian
+//   6       3*n   n x { sensor id (1 byte), value (int16 LE, hundredths) }
+//   6+3n    2     CRC-16/CCITT-FALSE of bytes 0..5+3n, little endian
+//
+// The frame is then COBS encoded, so it contains no zero bytes, and
+// terminated by a single 0x00 which the receiver uses to resync after
+// noise or a mid-frame connect.
+//
+// Values are fixed point in hundredths, the same precision Serial.print()
+// gave us, and saturate at +/-327.67.
+
+#ifndef SENSOR_FRAME_H
+#define SENSOR_FRAME_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define SENSOR_FRAME_VERSION      (1)
+#define SENSOR_FRAME_MAX_RECORDS  (8)
+#define SENSOR_FRAME_VALUE_SCALE  (100)
+#define SENSOR_FRAME_HEADER_SIZE  (6)
+#define SENSOR_FRAME_MAX_RAW      (SENSOR_FRAME_HEADER_SIZE + 3 * SENSOR_FRAME_MAX_RECORDS + 2)
+// COBS adds one byte per 254, plus the trailing delimiter
+#define SENSOR_FRAME_MAX_ENCODED  (SENSOR_FRAME_MAX_RAW + SENSOR_FRAME_MAX_RAW / 254 + 2)
+
+struct SensorFrameRecord
+{
+  uint8_t sensor;
+  int16_t value; // hundredths
+};
+
+struct SensorFrame
+{
+  uint32_t timestamp;
+  uint8_t count;
+  SensorFrameRecord records[SENSOR_FRAME_MAX_RECORDS];
+};
+
+struct SensorFrameDecoder
+{
+  uint8_t buffer[SENSOR_FRAME_MAX_ENCODED];
+  uint8_t length;
+  uint8_t overflowed;
+  uint32_t frames;        // frames that passed every check
+  uint32_t crcErrors;     // delimited frames with a bad checksum
+  uint32_t formatErrors;  // bad COBS, bad length, unknown version or overlong garbage
+};
+
+//==============================================================================
+// Shared helpers
+
+static inline uint16_t sensorFrameCrc16(const uint8_t* data, uint8_t length)
+{
+  uint16_t crc = 0xFFFF;
+  for (uint8_t idx = 0; idx < length; ++idx)
+  {
+    crc ^= (uint16_t) data[idx] << 8;
+    for (uint8_t bit = 0; bit < 8; ++bit)
+      crc = (crc & 0x8000) ? (uint16_t) ((crc << 1) ^ 0x1021) : (uint16_t) (crc << 1);
+  }
+  return crc;
+}
+
+static inline int16_t sensorFrameValueFromFloat(float value)
+{
+  float scaled = value * SENSOR_FRAME_VALUE_SCALE;
+  if (!(scaled == scaled)) // NaN
+    return 0;
+  if (scaled > 32767.0f)
+    return 32767;
+  if (scaled < -32768.0f)
+    return -32768;
+  return (int16_t) (scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+static inline float sensorFrameValueToFloat(int16_t value)
+{
+  return (float) value / (float) SENSOR_FRAME_VALUE_SCALE;
+}
+
+//==============================================================================
+// Encoder
+
+static inline void sensorFrameBegin(SensorFrame* frame, uint32_t timestamp)
+{
+  frame->timestamp = timestamp;
+  frame->count = 0;
+}
+
+// returns false if the frame is already full
+static inline bool sensorFrameAdd(SensorFrame* frame, uint8_t sensor, float value)
+{
+  if (frame->count >= SENSOR_FRAME_MAX_RECORDS)
+    return false;
+  frame->records[frame->count].sensor = sensor;
+  frame->records[frame->count].value = sensorFrameValueFromFloat(value);
+  ++frame->count;
+  return true;
+}
+
+// writes the COBS encoded frame plus delimiter to out (at least
+// SENSOR_FRAME_MAX_ENCODED bytes) and returns how many bytes to send
+static inline uint8_t sensorFrameEncode(const SensorFrame* frame, uint8_t* out)
+{
+  uint8_t raw[SENSOR_FRAME_MAX_RAW];
+  uint8_t length = 0;
+  raw[length++] = SENSOR_FRAME_VERSION;
+  raw[length++] = frame->count;
+  raw[length++] = (uint8_t) (frame->timestamp);
+  raw[length++] = (uint8_t) (frame->timestamp >> 8);
+  raw[length++] = (uint8_t) (frame->timestamp >> 16);
+  raw[length++] = (uint8_t) (frame->timestamp >> 24);
+  for (uint8_t idx = 0; idx < frame->count; ++idx)
+  {
+    uint16_t value = (uint16_t) frame->records[idx].value;
+    raw[length++] = frame->records[idx].sensor;
+    raw[length++] = (uint8_t) value;
+    raw[length++] = (uint8_t) (value >> 8);
+  }
+  uint16_t crc = sensorFrameCrc16(raw, length);
+  raw[length++] = (uint8_t) crc;
+  raw[length++] = (uint8_t) (crc >> 8);
+
+  // COBS: every zero is replaced by the distance to the next one
+  uint8_t written = 1;
+  uint8_t codeIdx = 0;
+  uint8_t code = 1;
+  for (uint8_t idx = 0; idx < length; ++idx)
+  {
+    if (raw[idx] == 0)
+    {
+      out[codeIdx] = code;
+      codeIdx = written++;
+      code = 1;
+    }
+    else
+    {
+      out[written++] = raw[idx];
+      if (++code == 0xFF)
+      {
+        out[codeIdx] = code;
+        codeIdx = written++;
+        code = 1;
+      }
+    }
+  }
+  out[codeIdx] = code;
+  out[written++] = 0x00;
+  return written;
+}
+
+//==============================================================================
+// Decoder
+
+static inline void sensorFrameDecoderReset(SensorFrameDecoder* decoder)
+{
+  memset(decoder, 0, sizeof(SensorFrameDecoder));
+}
+
+// validates one delimited, still COBS encoded frame
+static inline bool sensorFrameDecodeBuffer(SensorFrameDecoder* decoder, SensorFrame* frame)
+{
+  uint8_t raw[SENSOR_FRAME_MAX_ENCODED];
+  uint8_t length = 0;
+  uint8_t idx = 0;
+  while (idx < decoder->length)
+  {
+    uint8_t code = decoder->buffer[idx++];
+    if (code == 0 || idx + code - 1 > decoder->length)
+    {
+      ++decoder->formatErrors;
+      return false;
+    }
+    for (uint8_t run = 1; run < code; ++run)
+      raw[length++] = decoder->buffer[idx++];
+    if (code != 0xFF && idx < decoder->length)
+      raw[length++] = 0;
+  }
+
+  if (length < SENSOR_FRAME_HEADER_SIZE + 3 + 2
+      || raw[0] != SENSOR_FRAME_VERSION
+      || raw[1] == 0 || raw[1] > SENSOR_FRAME_MAX_RECORDS
+      || length != SENSOR_FRAME_HEADER_SIZE + 3 * raw[1] + 2)
+  {
+    ++decoder->formatErrors;
+    return false;
+  }
+
+  uint16_t crc = (uint16_t) (raw[length - 2] | (raw[length - 1] << 8));
+  if (crc != sensorFrameCrc16(raw, (uint8_t) (length - 2)))
+  {
+    ++decoder->crcErrors;
+    return false;
+  }
+
+  frame->count = raw[1];
+  frame->timestamp = (uint32_t) raw[2]
+                   | ((uint32_t) raw[3] << 8)
+                   | ((uint32_t) raw[4] << 16)
+                   | ((uint32_t) raw[5] << 24);
+  for (uint8_t rec = 0; rec < frame->count; ++rec)
+  {
+    const uint8_t* field = raw + SENSOR_FRAME_HEADER_SIZE + 3 * rec;
+    frame->records[rec].sensor = field[0];
+    frame->records[rec].value = (int16_t) (uint16_t) (field[1] | (field[2] << 8));
+  }
+  ++decoder->frames;
+  return true;
+}
+
+// Consumes bytes until a valid frame completes or the data runs out. Returns
+// the number of bytes consumed and sets *gotFrame when frame was filled in;
+// call again with the remaining bytes to pick up the next frame.
+static inline int sensorFrameDecode(SensorFrameDecoder* decoder,
+                                    const uint8_t* data, int numBytes,
+                                    SensorFrame* frame, bool* gotFrame)
+{
+  *gotFrame = false;
+  int consumed = 0;
+  while (consumed < numBytes)
+  {
+    const uint8_t* delimiter = (const uint8_t*) memchr(data + consumed, 0, (size_t) (numBytes - consumed));
+    int run = (int) ((delimiter != 0 ? delimiter : data + numBytes) - (data + consumed));
+
+    if (!decoder->overflowed)
+    {
+      if (decoder->length + run <= SENSOR_FRAME_MAX_ENCODED)
+      {
+        memcpy(decoder->buffer + decoder->length, data + consumed, (size_t) run);
+        decoder->length = (uint8_t) (decoder->length + run);
+      }
+      else
+      {
+        decoder->overflowed = 1;
+      }
+    }
+    consumed += run;
+
+    if (delimiter == 0)
+      break;
+
+    ++consumed; // the delimiter itself
+    if (decoder->overflowed)
+      ++decoder->formatErrors;
+    else if (decoder->length > 0 && sensorFrameDecodeBuffer(decoder, frame))
+      *gotFrame = true;
+    decoder->length = 0;
+    decoder->overflowed = 0;
+
+    if (*gotFrame)
+      break;
+  }
+  return consumed;
+}
+
+#endif // SENSOR_FRAME_H
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    AtomicValueBlock.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+namespace BioSignals
+{
+
+/**
+ The most recent value of a handful of controls, published by the ingest
+ thread (or the message thread, see SmoothedParameterBlock) and read by the
+ audio thread without either of them ever waiting.
+
+ Each control has its own slot holding the value and an update counter. A
+ reader remembers the counter it last saw and only picks up a value when the
+ counter has moved, so a slider that nobody touches costs one atomic load per
+ block.
+ */
+template <int numSlots>
+class AtomicValueBlock
+{
+public:
+  /** Writer side */
+  void publish(int slot, float value) noexcept
+  {
+    auto& s = slots_[slot];
+    s.value.store(value, std::memory_order_relaxed);
+    s.updates.fetch_add(1, std::memory_order_release);
+  }
+
+  /**
+   Reader side. Returns true and fills value if slot was published since
+   the call that last updated lastSeen.
+   */
+  bool readIfNewer(int slot, juce::uint32& lastSeen, float& value) const noexcept
+  {
+    const auto& s = slots_[slot];
+    const juce::uint32 updates = s.updates.load(std::memory_order_acquire);
+    if (updates == lastSeen)
+      return false;
+    value = s.value.load(std::memory_order_relaxed);
+    lastSeen = updates;
+    return true;
+  }
+
+  float getValue(int slot) const noexcept
+  {
+    return slots_[slot].value.load(std::memory_order_relaxed);
+  }
+
+  juce::uint32 getUpdateCount(int slot) const noexcept
+  {
+    return slots_[slot].updates.load(std::memory_order_acquire);
+  }
+
+private:
+  struct alignas(64) Slot // one cache line each, controls don't false-share
+  {
+    std::atomic<float> value { 0.0f };
+    std::atomic<juce::uint32> updates { 0 };
+  };
+
+  Slot slots_[numSlots];
+};
+
+} // namespace BioSignals
@@ -69,6 +69,8 @@ a typical serialport scenario may be:
 #define _SERIALPORT_H_
 
 #include <stdint.h>
+#include <errno.h>
+#include "juce_serialport_ringbuffer.h"
 
 #if JUCE_ANDROID
 	#include <jni.h>
@@ -76,6 +78,10 @@ a typical serialport scenario may be:
 
 using DebugFunction = std::function<void (juce::String, juce::String)>;
 
+//called on the reader thread with each chunk as it comes off the port, for consumers that can't wait
+//for the message thread to get round to them
+using SerialDataFunction = std::function<void (const unsigned char* data, int numBytes)>;
+
 class JUCE_API SerialPortConfig
 {
 public:
@@ -95,6 +101,37 @@ public:
 	SerialPortFlowControl flowcontrol;
 };
 
+/*How the reader thread pulls bytes off the port.
+
+READMODE_BYTE is the original behaviour: one ::read() of a single byte per loop iteration.
+READMODE_BLOCK waits for the descriptor to become readable (poll/select) and then drains
+everything the driver has queued, up to chunkSize bytes per ::read(), taking the buffer lock
+once per chunk instead of once per byte.
+
+vmin/vtime are applied to the termios VMIN/VTIME fields on POSIX backends. With vmin == 0 a
+::read() returns whatever is queued immediately; with vmin > 0 the driver holds the read back
+until vmin bytes arrived or vtime (tenths of a second) elapsed after the first byte, which lets
+the kernel batch bytes for us at high baud rates.
+
+lowLatency asks drivers that buffer on their own (FTDI's 16ms latency timer) to hand bytes
+over straight away.
+*/
+class JUCE_API SerialPortReadPolicy
+{
+public:
+	enum SerialPortReadMode{READMODE_BYTE, READMODE_BLOCK};
+
+	SerialPortReadPolicy(){};
+	SerialPortReadPolicy(SerialPortReadMode mode, uint8_t vmin, uint8_t vtime, int pollTimeoutMs = 100, int chunkSize = 4096) :
+        mode(mode), vmin(vmin), vtime(vtime), pollTimeoutMs(pollTimeoutMs), chunkSize(chunkSize) {}
+	SerialPortReadMode mode = READMODE_BLOCK;
+	uint8_t vmin = 0;
+	uint8_t vtime = 5;
+	int pollTimeoutMs = 100; //how long the reader waits for data before rechecking threadShouldExit()
+	int chunkSize = 4096;    //largest single ::read()
+	bool lowLatency = true;  //ASYNC_LOW_LATENCY on Linux, ignored elsewhere
+};
+
 //////////////////////////////////////////////////////////////////
 class JUCE_API SerialPort
 {
@@ -121,6 +158,11 @@ public:
 	void close();
 	bool setConfig(const SerialPortConfig & config);
 	bool getConfig(SerialPortConfig & config);
+	//set it before a SerialPortInputStream starts reading the port: while one is, the reader thread
+	//is using the policy and this returns false without changing it. the VMIN/VTIME part is ignored
+	//where the backend has no termios
+	bool setReadPolicy(const SerialPortReadPolicy & policy);
+	const SerialPortReadPolicy & getReadPolicy() const {return readPolicy;}
 	juce::String getPortPath(){return portPath;}
 	static juce::StringPairArray getSerialPortPaths();
 	bool exists();
@@ -131,10 +173,13 @@ public:
 private:
 	friend class SerialPortInputStream;
 	friend class SerialPortOutputStream;
+	friend class SerialPortMultiplexer;
 	void * portHandle;
 	int portDescriptor;
     bool canceled;
 	juce::String portPath;
+	SerialPortReadPolicy readPolicy;
+	std::atomic<int> numReaders { 0 }; //SerialPortInputStreams reading readPolicy right now
 
     DebugFunction DebugLogInternal;
 
@@ -147,9 +192,19 @@ private:
 class JUCE_API SerialPortInputStream : public juce::InputStream, public juce::ChangeBroadcaster, private juce::Thread
 {
 public:
-    SerialPortInputStream(SerialPort * port) :
-		Thread("SerialInThread"), port(port),bufferedbytes(0), notify(NOTIFY_OFF), notifyChar(0)
+    //bufferCapacity is how many received bytes can wait for the consumer before new ones get dropped
+    SerialPortInputStream(SerialPort * port, uint32_t bufferCapacity = 1 << 16) :
+		Thread("SerialInThread"), port(port), buffer(bufferCapacity), notify(NOTIFY_OFF), notifyChar(0)
+	{
+		++port->numReaders;
+		startThread();
+	}
+    //bytes go straight to onData on the reader thread instead of into the buffer, and no change
+    //messages are sent. onData must not block, it holds up the port
+    SerialPortInputStream(SerialPort * port, SerialDataFunction onData, uint32_t bufferCapacity = 1 << 16) :
+		Thread("SerialInThread"), port(port), buffer(bufferCapacity), notify(NOTIFY_OFF), notifyChar(0), onData(std::move(onData))
 	{
+		++port->numReaders;
 		startThread();
 	}
 
@@ -158,6 +213,7 @@ public:
 		signalThreadShouldExit();
         cancel ();
         waitForThreadToExit (5000);
+		--port->numReaders;
 	}
 
 	enum notifyflag{NOTIFY_OFF=0, NOTIFY_ON_CHAR, NOTIFY_ALWAYS};
@@ -167,23 +223,15 @@ public:
 		this->notify = _notify;
 	}
 
+	//the read side (read, readNextLine, canRead*, getTotalLength, isExhausted) must only be used from one thread at a time
 	bool canReadString()
 	{
-		const juce::ScopedLock l (bufferCriticalSection);
-		int iNdx=0;
-		while (iNdx < bufferedbytes)
-			if(buffer[iNdx++]==0)return true;
-		return false;
+		return buffer.contains(0);
 	}
 
 	bool canReadLine()
 	{
-		const juce::ScopedLock l (bufferCriticalSection);
-		int iNdx=0;
-		while (iNdx < bufferedbytes)
-			if (buffer[iNdx++]=='\n' /*|| (buffer[iNdx++]=='\r')*/)
-				return true;
-		return false;
+		return buffer.contains('\n');
 	}
 
 	virtual void run();
@@ -201,14 +249,12 @@ public:
 
 	virtual juce::int64 getTotalLength()
 	{
-		const juce::ScopedLock l(bufferCriticalSection);
-		return bufferedbytes;
+		return buffer.getNumReady();
 	};
 
 	virtual bool isExhausted()
 	{
-		const juce::ScopedLock l(bufferCriticalSection);
-		return bufferedbytes ? false : true;
+		return buffer.getNumReady() ? false : true;
 	};
 
 	virtual juce::int64 getPosition(){return 0;}
@@ -217,13 +263,32 @@ public:
     SerialPort* getPort() { return port; }
     void setReaderPriority (int priority) { setPriority (priority); }
 
+	//bytes the reader thread had to throw away because the consumer fell behind
+	juce::uint64 getOverflowBytes() const { return buffer.getOverflowBytes(); }
+	juce::uint64 getOverflowEvents() const { return buffer.getOverflowEvents(); }
+	juce::uint64 getTotalBytesReceived() const { return buffer.getTotalWritten(); }
+
 private:
+	//hand freshly received bytes to the ring buffer and fire the change message if asked to.
+	//never blocks, whatever the consumer is doing
+	void bufferIncoming(const unsigned char* data, int numBytes)
+	{
+		if (onData != nullptr)
+		{
+			onData (data, numBytes);
+			return;
+		}
+		const int stored = buffer.write (data, numBytes);
+		if (stored > 0
+		    && (notify == NOTIFY_ALWAYS || (notify == NOTIFY_ON_CHAR && memchr (data, notifyChar, stored) != nullptr)))
+			sendChangeMessage();
+	}
+
 	SerialPort* port;
-	int bufferedbytes;
-	juce::MemoryBlock buffer;
-	juce::CriticalSection bufferCriticalSection;
+	SerialRingBuffer buffer;
 	notifyflag notify;
 	char notifyChar;
+	const SerialDataFunction onData;
 };
 
 //////////////////////////////////////////////////////////////////
@@ -263,4 +328,77 @@ private:
 	juce::WaitableEvent triggerWrite;
 	static const uint32_t writeBufferSize = 128;
 };
+//////////////////////////////////////////////////////////////////
+
+/*Reads any number of ports from one thread, instead of one SerialPortInputStream (and one thread)
+per port. The thread sleeps in epoll_wait() on Linux and select() on macOS, and hands every chunk
+to onData on that thread, along with the index addPort() returned for the port it came from.
+Chunks come out in the order they were read, so onData sees one merged stream.
+
+Add the ports before calling start(); they aren't owned and must outlive the multiplexer. A port
+that errors or gets unplugged is closed and dropped, the others carry on. Windows and iOS have no
+implementation, start() returns false there.
+*/
+class JUCE_API SerialPortMultiplexer : private juce::Thread
+{
+public:
+	using DataFunction = std::function<void (int portIndex, const unsigned char* data, int numBytes)>;
+
+	SerialPortMultiplexer(DataFunction onData, int pollTimeoutMs = 100, int chunkSize = 4096) :
+		Thread("SerialMuxThread"), onData(std::move(onData)), pollTimeoutMs(pollTimeoutMs), chunkSize(chunkSize)
+	{
+	}
+
+	virtual ~SerialPortMultiplexer()
+	{
+		signalThreadShouldExit();
+		waitForThreadToExit(5000);
+	}
+
+	static bool isSupported()
+	{
+#if JUCE_LINUX || JUCE_MAC
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	int addPort(SerialPort * port)
+	{
+		jassert (! isThreadRunning());
+		ports.add(port);
+		return ports.size() - 1;
+	}
+
+	bool start()
+	{
+		if (! isSupported() || ports.isEmpty())
+			return false;
+		numOpenPorts = ports.size();
+		startThread();
+		return true;
+	}
+
+	int getNumPorts() const { return ports.size(); }
+	int getNumOpenPorts() const { return numOpenPorts.load(); }
+	void setReaderPriority (int priority) { setPriority (priority); }
+
+	virtual void run();
+
+private:
+	void dropPort(int portIndex, const juce::String& why)
+	{
+		ports[portIndex]->DebugLog ("SerialPortMultiplexer::run", why + ", errno: " + juce::String (errno));
+		ports[portIndex]->close();
+		--numOpenPorts;
+	}
+
+	const DataFunction onData;
+	juce::Array<SerialPort*> ports;
+	const int pollTimeoutMs;
+	const int chunkSize;
+	std::atomic<int> numOpenPorts { 0 };
+};
+
 #endif //_SERIALPORT_H_
@@ -0,0 +1,505 @@
+//linux_SerialPort.cpp
+//Serial Port classes in a Juce stylee
+//see SerialPort.h for details
+//
+//Native Linux backend: termios2/BOTHER for arbitrary baud rates (USB serial adapters
+//and the 32u4/SAMD boards happily run at 1-2 Mbaud), ASYNC_LOW_LATENCY so FTDI style
+//drivers don't sit on bytes for their 16ms latency timer, exclusive open, and port
+//enumeration through sysfs. Works just as well on a pseudo-terminal slave, which is
+//how the sensor simulator and any pty based testing connect.
+//
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if JUCE_LINUX
+
+using namespace juce;
+
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+//termios2 lives in the kernel headers and clashes with glibc's <termios.h>,
+//so everything termios related goes through ioctl() here
+#include <asm/termbits.h>
+#include <asm/ioctls.h>
+#include <linux/serial.h>
+extern "C" int ioctl (int fd, unsigned long request, ...);
+#include "juce_serialport.h"
+
+namespace
+{
+	//glibc's cfmakeraw(), for a termios2
+	void makeRaw (struct termios2& options)
+	{
+		options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON);
+		options.c_oflag &= ~OPOST;
+		options.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+		options.c_cflag &= ~(CSIZE | PARENB);
+		options.c_cflag |= CS8;
+	}
+
+	String readSysfsString (const String& path)
+	{
+		String result;
+		if (FILE* f = fopen (path.toRawUTF8(), "r"))
+		{
+			char line[256];
+			if (fgets (line, sizeof (line), f) != nullptr)
+				result = String (line).trim();
+			fclose (f);
+		}
+		return result;
+	}
+
+	//the tty's device link points at the USB interface, the product string lives a
+	//level or two further up on the USB device itself
+	String getUsbProductName (const String& ttyName)
+	{
+		char resolved[PATH_MAX];
+		const String deviceLink = "/sys/class/tty/" + ttyName + "/device";
+		if (realpath (deviceLink.toRawUTF8(), resolved) == nullptr)
+			return {};
+
+		String dir (resolved);
+		for (int level = 0; level < 3 && dir.isNotEmpty(); ++level)
+		{
+			const String product = readSysfsString (dir + "/product");
+			if (product.isNotEmpty())
+			{
+				const String manufacturer = readSysfsString (dir + "/manufacturer");
+				return manufacturer.isNotEmpty() ? manufacturer + " " + product : product;
+			}
+			dir = dir.upToLastOccurrenceOf ("/", false, false);
+		}
+		return {};
+	}
+}
+
+StringPairArray SerialPort::getSerialPortPaths()
+{
+	StringPairArray SerialPortPaths;
+	DIR* ttys = opendir ("/sys/class/tty");
+	if (ttys == nullptr)
+	{
+		DBG ("SerialPort::getSerialPortPaths : can't open /sys/class/tty");
+		return SerialPortPaths;
+	}
+	while (struct dirent* entry = readdir (ttys))
+	{
+		const String name (entry->d_name);
+		if (! name.startsWith ("ttyACM") && ! name.startsWith ("ttyUSB"))
+			continue;
+
+		const String product = getUsbProductName (name);
+		SerialPortPaths.set (product.isNotEmpty() ? name + " (" + product + ")" : name, "/dev/" + name);
+	}
+	closedir (ttys);
+	return SerialPortPaths;
+}
+bool SerialPort::exists()
+{
+	return (-1!=portDescriptor);
+}
+void SerialPort::close()
+{
+    DebugLog ("SerialPort::close", "closing port:" + portPath);
+
+	if(-1 != portDescriptor)
+	{
+		::close(portDescriptor); //also drops the flock
+		portDescriptor = -1;
+	}
+}
+bool SerialPort::open(const String & portPath)
+{
+	this->portPath = portPath;
+    DebugLog ("SerialPort::open", "opening port:" + this->portPath);
+
+	portDescriptor = ::open(portPath.toRawUTF8(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (portDescriptor == -1)
+    {
+        DebugLog ("SerialPort::open", "open() failed, errno: " + String (errno));
+        return false;
+    }
+    // don't allow multiple opens: TIOCEXCL stops other non-root opens of the tty,
+    // the advisory lock is what other serial tools (and other instances of us) check
+    if (flock(portDescriptor, LOCK_EX | LOCK_NB) == -1)
+    {
+        DebugLog ("SerialPort::open", "port is in use by another process");
+		close();
+        return false;
+    }
+    if (ioctl(portDescriptor, TIOCEXCL) == -1)
+    {
+        DebugLog ("SerialPort::open", "ioctl(TIOCEXCL) error, non critical");
+    }
+    // we want blocking io actually, the reader polls before it reads
+	if (fcntl(portDescriptor, F_SETFL, 0) == -1)
+    {
+        DebugLog ("SerialPort::open", "fcntl error");
+		close();
+        return false;
+    }
+	struct termios2 options;
+    if (ioctl(portDescriptor, TCGETS2, &options) == -1)
+    {
+        DebugLog ("SerialPort::open", "can't get port settings to set timeouts");
+		close();
+        return false;
+    }
+	makeRaw(options);
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
+	if (ioctl(portDescriptor, TCSETS2, &options) == -1)
+    {
+        DebugLog ("SerialPort::open", "can't set port settings (timeouts)");
+		close();
+        return false;
+    }
+	if (readPolicy.lowLatency)
+	{
+		// ask the driver to push bytes up immediately rather than batching them.
+		// not every driver has the knob (cdc-acm and ptys don't), so it's only a hint
+		struct serial_struct serial;
+		if (ioctl(portDescriptor, TIOCGSERIAL, &serial) == 0)
+		{
+			serial.flags |= ASYNC_LOW_LATENCY;
+			if (ioctl(portDescriptor, TIOCSSERIAL, &serial) == -1)
+				DebugLog ("SerialPort::open", "can't set ASYNC_LOW_LATENCY, non critical");
+		}
+	}
+	return true;
+}
+void SerialPort::cancel ()
+{
+}
+
+bool SerialPort::setConfig(const SerialPortConfig & config)
+{
+	if(-1==portDescriptor)return false;
+	struct termios2 options;
+	memset(&options, 0, sizeof(options));
+	//non canocal, timeouts from the read policy
+	makeRaw(options);
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
+	options.c_cflag |= CREAD; //enable reciever (daft)
+	options.c_cflag |= CLOCAL;//don't monitor modem control lines
+	//baud: BOTHER takes the rate verbatim instead of picking from the Bxxx table
+	options.c_cflag &= ~CBAUD;
+	options.c_cflag |= BOTHER;
+	options.c_ispeed = config.bps;
+	options.c_ospeed = config.bps;
+	//bits
+	options.c_cflag &= ~CSIZE;
+	switch(config.databits)
+	{
+		case 5: options.c_cflag |= CS5; break;
+		case 6: options.c_cflag |= CS6; break;
+		case 7: options.c_cflag |= CS7; break;
+		case 8: default: options.c_cflag |= CS8; break;
+	}
+	//parity
+	switch(config.parity)
+	{
+	case SerialPortConfig::SERIALPORT_PARITY_ODD:
+		options.c_cflag |= PARENB;
+		options.c_cflag |= PARODD;
+		break;
+	case SerialPortConfig::SERIALPORT_PARITY_EVEN:
+		options.c_cflag |= PARENB;
+		break;
+	case SerialPortConfig::SERIALPORT_PARITY_MARK:
+		options.c_cflag |= PARENB | CMSPAR | PARODD;
+		break;
+	case SerialPortConfig::SERIALPORT_PARITY_SPACE:
+		options.c_cflag |= PARENB | CMSPAR;
+		break;
+	case SerialPortConfig::SERIALPORT_PARITY_NONE:
+	default:
+		break;
+	}
+	//stopbits
+	if (config.stopbits==SerialPortConfig::STOPBITS_1ANDHALF)
+	{
+		DebugLog ("SerialPort::setConfig", "STOPBITS_1ANDHALF not supported on Linux");
+		return false;//not supported
+	}
+	if(config.stopbits==SerialPortConfig::STOPBITS_2)
+		options.c_cflag |= CSTOPB;
+	//flow control
+	switch(config.flowcontrol)
+	{
+	case SerialPortConfig::FLOWCONTROL_XONXOFF:
+		options.c_iflag |= IXON;
+		options.c_iflag |= IXOFF;
+		break;
+	case SerialPortConfig::FLOWCONTROL_HARDWARE:
+		options.c_cflag |= CRTSCTS;
+		break;
+	case SerialPortConfig::FLOWCONTROL_NONE:
+	default:
+		break;
+	}
+	if (ioctl(portDescriptor, TCSETS2, &options) == -1)
+    {
+        DebugLog("SerialPort::setConfig", "can't set port settings, errno: " + String (errno));
+        return false;
+    }
+	return true;
+}
+bool SerialPort::setReadPolicy(const SerialPortReadPolicy & policy)
+{
+	if (numReaders > 0)
+    {
+        DebugLog("SerialPort::setReadPolicy", "can't change the read policy while the port is being read");
+        return false;
+    }
+	readPolicy = policy;
+	if(-1==portDescriptor)return true; //applied on the next open()
+	struct termios2 options;
+	if (ioctl(portDescriptor, TCGETS2, &options) == -1)
+    {
+        DebugLog("SerialPort::setReadPolicy", "cannot get port settings");
+        return false;
+    }
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
+	if (ioctl(portDescriptor, TCSETS2, &options) == -1)
+    {
+        DebugLog("SerialPort::setReadPolicy", "can't set port timeouts");
+        return false;
+    }
+	return true;
+}
+bool SerialPort::getConfig(SerialPortConfig & config)
+{
+	struct termios2 options;
+	if(-1==portDescriptor)return false;
+	if (ioctl(portDescriptor, TCGETS2, &options) == -1)
+    {
+        DebugLog("SerialPort::getConfig", "cannot get port settings");
+        return false;
+    }
+	config.bps = options.c_ispeed > options.c_ospeed ? options.c_ispeed : options.c_ospeed;
+	switch(options.c_cflag & CSIZE)
+	{
+	case CS5: config.databits=5; break;
+	case CS6: config.databits=6; break;
+	case CS7: config.databits=7; break;
+	case CS8: config.databits=8; break;
+	}
+	config.parity = SerialPortConfig::SERIALPORT_PARITY_NONE;
+	if(options.c_cflag & PARENB)
+	{
+		if(options.c_cflag & CMSPAR)
+			config.parity = (options.c_cflag & PARODD) ? SerialPortConfig::SERIALPORT_PARITY_MARK : SerialPortConfig::SERIALPORT_PARITY_SPACE;
+		else if(options.c_cflag & PARODD)config.parity = SerialPortConfig::SERIALPORT_PARITY_ODD;
+		else config.parity = SerialPortConfig::SERIALPORT_PARITY_EVEN;
+	}
+	//stopbits
+	config.stopbits = SerialPortConfig::STOPBITS_1;
+	if(options.c_cflag & CSTOPB)config.stopbits = SerialPortConfig::STOPBITS_2;
+	//flow control
+	config.flowcontrol=SerialPortConfig::FLOWCONTROL_NONE;
+	if((options.c_iflag & IXON) || (options.c_iflag & IXOFF))
+		config.flowcontrol=SerialPortConfig::FLOWCONTROL_XONXOFF;
+	else if(options.c_cflag & CRTSCTS)
+		config.flowcontrol=SerialPortConfig::FLOWCONTROL_HARDWARE;
+
+	return true;
+}
+/////////////////////////////////
+// SerialPortInputStream
+/////////////////////////////////
+void SerialPortInputStream::cancel ()
+{
+}
+
+void SerialPortInputStream::run()
+{
+    port->DebugLog ("SerialPortInputStream::run", "starting thread");
+
+    if (port->readPolicy.mode == SerialPortReadPolicy::READMODE_BYTE)
+    {
+        while (port != nullptr && port->portDescriptor != -1 && ! threadShouldExit ())
+        {
+            unsigned char c;
+            //this call will block until we read 1 byte, or ::read() returns an error, caught below
+            const auto bytesread = ::read (port->portDescriptor, &c, 1);
+            if (bytesread == 1)
+            {
+                bufferIncoming (&c, 1);
+            }
+            else if (bytesread == -1)
+            {
+                port->DebugLog ("SerialPortInputStream::run", "::read() returned " + String(bytesread) + ", errno: " + String (errno));
+                port->close ();
+                break;
+            }
+        }
+    }
+    else
+    {
+        const int chunkSize = jmax (1, port->readPolicy.chunkSize);
+        HeapBlock<unsigned char> chunk (chunkSize);
+
+        while (port != nullptr && port->portDescriptor != -1 && ! threadShouldExit ())
+        {
+            //wait until the driver has something for us, waking up regularly to check threadShouldExit()
+            struct pollfd pfd;
+            pfd.fd = port->portDescriptor;
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+            const int ready = ::poll (&pfd, 1, port->readPolicy.pollTimeoutMs);
+            if (ready == 0 || (ready == -1 && errno == EINTR))
+                continue;
+            if (ready == -1 || (pfd.revents & (POLLERR | POLLNVAL)))
+            {
+                port->DebugLog ("SerialPortInputStream::run", "::poll() failed, errno: " + String (errno));
+                port->close ();
+                break;
+            }
+
+            //drain everything queued, one chunk at a time
+            const auto bytesread = ::read (port->portDescriptor, chunk.getData(), (size_t) chunkSize);
+            if (bytesread > 0)
+            {
+                bufferIncoming (chunk.getData(), (int) bytesread);
+            }
+            else if ((bytesread == -1 && errno != EAGAIN && errno != EINTR)
+                     || (bytesread == 0 && (pfd.revents & POLLHUP)))
+            {
+                //a USB device being unplugged or the pty master going away ends up here
+                port->DebugLog ("SerialPortInputStream::run", "::read() returned " + String(bytesread) + ", errno: " + String (errno));
+                port->close ();
+                break;
+            }
+        }
+    }
+
+    port->DebugLog ("SerialPortInputStream::run", "stoping thread");
+}
+
+int SerialPortInputStream::read(void *destBuffer, int maxBytesToRead)
+{
+    if (port != nullptr && port->portDescriptor != -1)
+        return buffer.read (destBuffer, maxBytesToRead);
+    else
+        return -1;
+}
+/////////////////////////////////
+// SerialPortOutputStream
+/////////////////////////////////
+void SerialPortOutputStream::cancel ()
+{
+}
+
+void SerialPortOutputStream::run()
+{
+    port->DebugLog ("SerialPortOutputStream::run", "starting thread");
+
+    unsigned char tempbuffer[writeBufferSize];
+    while(port && (port->portDescriptor!=-1) && !threadShouldExit())
+    {
+        if (! bufferedbytes)
+            triggerWrite.wait(100);
+        if (bufferedbytes)
+        {
+            bufferCriticalSection.enter();
+            int bytestowrite = bufferedbytes > writeBufferSize ? writeBufferSize : bufferedbytes;
+            memcpy (tempbuffer, buffer.getData(), bytestowrite);
+            bufferCriticalSection.exit();
+            const auto byteswritten = ::write(port->portDescriptor, tempbuffer, bytestowrite);
+            if (byteswritten>0)
+            {
+                const ScopedLock l(bufferCriticalSection);
+                buffer.removeSection(0, byteswritten);
+                bufferedbytes-=byteswritten;
+            }
+            else
+            {
+                port->DebugLog ("SerialPortOutputStream::run", "::write() couldn't write anything, errno: " + String (errno));
+                port->close ();
+                break;
+            }
+        }
+    }
+    port->DebugLog ("SerialPortOutputStream::run", "stoping thread");
+}
+
+bool SerialPortOutputStream::write(const void *dataToWrite, size_t howManyBytes)
+{
+	bufferCriticalSection.enter();
+    buffer.append(dataToWrite, howManyBytes);
+	bufferedbytes+=howManyBytes;
+	bufferCriticalSection.exit();
+	triggerWrite.signal();
+	return true;
+}
+
+//========== SerialPortMultiplexer ==========
+void SerialPortMultiplexer::run()
+{
+    const int epollDescriptor = ::epoll_create1 (EPOLL_CLOEXEC);
+    if (epollDescriptor == -1)
+    {
+        ports[0]->DebugLog ("SerialPortMultiplexer::run", "::epoll_create1() failed, errno: " + String (errno));
+        return;
+    }
+
+    for (int idx = 0; idx < ports.size(); ++idx)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t) idx;
+        if (ports[idx]->portDescriptor == -1
+            || ::epoll_ctl (epollDescriptor, EPOLL_CTL_ADD, ports[idx]->portDescriptor, &ev) == -1)
+            dropPort (idx, "can't watch port");
+    }
+
+    HeapBlock<unsigned char> chunk (jmax (1, chunkSize));
+    HeapBlock<struct epoll_event> events (ports.size());
+
+    while (numOpenPorts > 0 && ! threadShouldExit ())
+    {
+        //level triggered, so a port with more queued than one chunk just comes round again
+        const int ready = ::epoll_wait (epollDescriptor, events.getData(), ports.size(), pollTimeoutMs);
+        if (ready == -1 && errno != EINTR)
+        {
+            ports[0]->DebugLog ("SerialPortMultiplexer::run", "::epoll_wait() failed, errno: " + String (errno));
+            break;
+        }
+
+        for (int evIdx = 0; evIdx < ready; ++evIdx)
+        {
+            const int idx = (int) events[evIdx].data.u32;
+            const int fd = ports[idx]->portDescriptor;
+            if (fd == -1)
+                continue;
+
+            const auto bytesread = ::read (fd, chunk.getData(), (size_t) jmax (1, chunkSize));
+            if (bytesread > 0)
+            {
+                onData (idx, chunk.getData(), (int) bytesread);
+            }
+            else if ((bytesread == -1 && errno != EAGAIN && errno != EINTR)
+                     || (bytesread == 0 && (events[evIdx].events & (EPOLLHUP | EPOLLERR))))
+            {
+                ::epoll_ctl (epollDescriptor, EPOLL_CTL_DEL, fd, nullptr);
+                dropPort (idx, "::read() returned " + String (bytesread));
+            }
+        }
+    }
+
+    ::close (epollDescriptor);
+}
+
+#endif // JUCE_LINUX
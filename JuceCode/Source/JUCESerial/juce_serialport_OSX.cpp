@@ -16,6 +16,7 @@ using namespace juce;
 #include <stdio.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <sys/select.h>
 #include <termios.h>
 #include <IOKit/serial/IOSerialKeys.h>
 #include <IOKit/usb/IOUSBLib.h>
@@ -117,10 +118,10 @@ bool SerialPort::open(const String & portPath)
 		close();
         return false;
     }
-	//non canocal, 0.5 second timeout, read returns as soon as any data is recieved
+	//non canocal, timeouts from the read policy (by default 0.5 second, read returns as soon as any data is recieved)
 	cfmakeraw(&options);
-    options.c_cc[VMIN] = 0;
-    options.c_cc[VTIME] = 5;
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
 	if (tcsetattr(portDescriptor, TCSANOW, &options) == -1)
     {
         DebugLog ("SerialPort::open", "can't set port settings (timeouts)");
@@ -138,10 +139,10 @@ bool SerialPort::setConfig(const SerialPortConfig & config)
 	if(-1==portDescriptor)return false;
 	struct termios options;
 	memset(&options, 0, sizeof(struct termios));
-	//non canocal, 0.5 second timeout, read returns as soon as any data is recieved
+	//non canocal, timeouts from the read policy
 	cfmakeraw(&options);
-    options.c_cc[VMIN] = 0;
-    options.c_cc[VTIME] = 5;
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
 	options.c_cflag |= CREAD; //enable reciever (daft)
 	options.c_cflag |= CLOCAL;//don't monitor modem control lines
 	//baud and bits
@@ -210,6 +211,30 @@ bool SerialPort::setConfig(const SerialPortConfig & config)
     
 	return true;
 }
+bool SerialPort::setReadPolicy(const SerialPortReadPolicy & policy)
+{
+	if (numReaders > 0)
+    {
+        DebugLog("SerialPort::setReadPolicy", "can't change the read policy while the port is being read");
+        return false;
+    }
+	readPolicy = policy;
+	if(-1==portDescriptor)return true; //applied on the next open()
+	struct termios options;
+	if (tcgetattr(portDescriptor, &options) == -1)
+    {
+        DebugLog("SerialPort::setReadPolicy", "cannot get port settings");
+        return false;
+    }
+    options.c_cc[VMIN] = readPolicy.vmin;
+    options.c_cc[VTIME] = readPolicy.vtime;
+	if (tcsetattr(portDescriptor, TCSANOW, &options) == -1)
+    {
+        DebugLog("SerialPort::setReadPolicy", "can't set port timeouts");
+        return false;
+    }
+	return true;
+}
 bool SerialPort::getConfig(SerialPortConfig & config)
 {
 	struct termios options;
@@ -256,27 +281,63 @@ void SerialPortInputStream::run()
 {
     port->DebugLog ("SerialPortInputStream::run", "starting thread");
 
-    while (port != nullptr && port->portDescriptor != -1 && ! threadShouldExit ())
+    if (port->readPolicy.mode == SerialPortReadPolicy::READMODE_BYTE)
     {
-        unsigned char c;
-        //this call will block until we read 1 byte, or ::read() returns an error, caught below
-        const auto bytesread = ::read (port->portDescriptor, &c, 1);
-        if (bytesread == 1)
+        while (port != nullptr && port->portDescriptor != -1 && ! threadShouldExit ())
         {
-            const ScopedLock l (bufferCriticalSection);
-
-            buffer.ensureSize (bufferedbytes + 1);
-            buffer[bufferedbytes] = c;
-            ++bufferedbytes;
-
-            if (notify == NOTIFY_ALWAYS || (notify == NOTIFY_ON_CHAR && c == notifyChar))
-                sendChangeMessage();
+            unsigned char c;
+            //this call will block until we read 1 byte, or ::read() returns an error, caught below
+            const auto bytesread = ::read (port->portDescriptor, &c, 1);
+            if (bytesread == 1)
+            {
+                bufferIncoming (&c, 1);
+            }
+            else if (bytesread == -1)
+            {
+                port->DebugLog ("SerialPortInputStream::run", "::read() returned " + String(bytesread) + ", errno: " + String (errno));
+                port->close ();
+                break;
+            }
         }
-        else if (bytesread == -1)
+    }
+    else
+    {
+        const int chunkSize = jmax (1, port->readPolicy.chunkSize);
+        HeapBlock<unsigned char> chunk (chunkSize);
+
+        while (port != nullptr && port->portDescriptor != -1 && ! threadShouldExit ())
         {
-            port->DebugLog ("SerialPortInputStream::run", "::read() returned " + String(bytesread) + ", errno: " + String (errno));
-            port->close ();
-            break;
+            //wait until the driver has something for us, waking up regularly to check threadShouldExit()
+            //(select rather than poll: poll() is unreliable on character devices on macOS)
+            const int fd = port->portDescriptor;
+            fd_set readfds;
+            FD_ZERO (&readfds);
+            FD_SET (fd, &readfds);
+            struct timeval timeout;
+            timeout.tv_sec = port->readPolicy.pollTimeoutMs / 1000;
+            timeout.tv_usec = (port->readPolicy.pollTimeoutMs % 1000) * 1000;
+            const int ready = ::select (fd + 1, &readfds, nullptr, nullptr, &timeout);
+            if (ready == 0 || (ready == -1 && errno == EINTR))
+                continue;
+            if (ready == -1)
+            {
+                port->DebugLog ("SerialPortInputStream::run", "::select() failed, errno: " + String (errno));
+                port->close ();
+                break;
+            }
+
+            //drain everything queued, one chunk and one buffer lock at a time
+            const auto bytesread = ::read (port->portDescriptor, chunk.getData(), (size_t) chunkSize);
+            if (bytesread > 0)
+            {
+                bufferIncoming (chunk.getData(), (int) bytesread);
+            }
+            else if (bytesread == -1 && errno != EAGAIN && errno != EINTR)
+            {
+                port->DebugLog ("SerialPortInputStream::run", "::read() returned " + String(bytesread) + ", errno: " + String (errno));
+                port->close ();
+                break;
+            }
         }
     }
 
@@ -286,18 +347,7 @@ void SerialPortInputStream::run()
 int SerialPortInputStream::read(void *destBuffer, int maxBytesToRead)
 {
     if (port != nullptr && port->portDescriptor != -1)
-    {
-        const ScopedLock l (bufferCriticalSection);
-
-        if (maxBytesToRead > bufferedbytes)
-            maxBytesToRead = bufferedbytes;
-
-        memcpy (destBuffer, buffer.getData(), maxBytesToRead);
-        buffer.removeSection (0,maxBytesToRead);
-        bufferedbytes -= maxBytesToRead;
-
-        return maxBytesToRead;
-    }
+        return buffer.read (destBuffer, maxBytesToRead);
     else
         return -1;
 }
@@ -351,4 +401,51 @@ bool SerialPortOutputStream::write(const void *dataToWrite, size_t howManyBytes)
 	return true;
 }
 
+//========== SerialPortMultiplexer ==========
+void SerialPortMultiplexer::run()
+{
+    //select() for the same reason as SerialPortInputStream::run(); FD_SETSIZE is plenty of ports
+    HeapBlock<unsigned char> chunk (jmax (1, chunkSize));
+
+    while (numOpenPorts > 0 && ! threadShouldExit ())
+    {
+        fd_set readfds;
+        FD_ZERO (&readfds);
+        int maxfd = -1;
+        for (auto* port : ports)
+        {
+            if (port->portDescriptor != -1)
+            {
+                FD_SET (port->portDescriptor, &readfds);
+                maxfd = jmax (maxfd, port->portDescriptor);
+            }
+        }
+
+        struct timeval timeout;
+        timeout.tv_sec = pollTimeoutMs / 1000;
+        timeout.tv_usec = (pollTimeoutMs % 1000) * 1000;
+        const int ready = ::select (maxfd + 1, &readfds, nullptr, nullptr, &timeout);
+        if (ready == 0 || (ready == -1 && errno == EINTR))
+            continue;
+        if (ready == -1)
+        {
+            ports[0]->DebugLog ("SerialPortMultiplexer::run", "::select() failed, errno: " + String (errno));
+            break;
+        }
+
+        for (int idx = 0; idx < ports.size(); ++idx)
+        {
+            const int fd = ports[idx]->portDescriptor;
+            if (fd == -1 || ! FD_ISSET (fd, &readfds))
+                continue;
+
+            const auto bytesread = ::read (fd, chunk.getData(), (size_t) jmax (1, chunkSize));
+            if (bytesread > 0)
+                onData (idx, chunk.getData(), (int) bytesread);
+            else if (bytesread == 0 || (errno != EAGAIN && errno != EINTR))
+                dropPort (idx, "::read() returned " + String (bytesread));
+        }
+    }
+}
+
 #endif // JUCE_MAC
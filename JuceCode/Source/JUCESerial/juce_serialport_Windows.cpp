@@ -246,6 +246,18 @@ bool SerialPort::setConfig(const SerialPortConfig & config)
     return (SetCommState(portHandle, &dcb) ? true : false);
 }
 
+bool SerialPort::setReadPolicy(const SerialPortReadPolicy & policy)
+{
+    //no VMIN/VTIME here, the comm timeouts set in open() already return as soon as anything is queued
+    if (numReaders > 0)
+    {
+        DebugLog("SerialPort::setReadPolicy", "can't change the read policy while the port is being read");
+        return false;
+    }
+    readPolicy = policy;
+    return true;
+}
+
 bool SerialPort::getConfig(SerialPortConfig & config)
 {
     if (!portHandle)return false;
@@ -309,9 +321,11 @@ void SerialPortInputStream::run()
     OVERLAPPED ovRead;
     memset(&ovRead, 0, sizeof(ovRead));
     ovRead.hEvent = CreateEvent(0, true, 0, 0);
+    const bool blockMode = port->readPolicy.mode == SerialPortReadPolicy::READMODE_BLOCK;
+    const int chunkSize = blockMode ? jmax (1, port->readPolicy.chunkSize) : 1;
+    HeapBlock<unsigned char> chunk (chunkSize);
     while (port && port->portHandle && !threadShouldExit())
     {
-        unsigned char c;
         DWORD bytesread = 0;
         const auto wceReturn = WaitCommEvent(port->portHandle, &dwEventMask, &ov);
 //         if (dwEventMask != 0)
@@ -332,20 +346,20 @@ void SerialPortInputStream::run()
                 {
                     do
                     {
+                        //in block mode ask the driver how much is queued and take all of it in one ReadFile
+                        DWORD bytestoread = 1;
+                        COMSTAT comStat;
+                        if (blockMode && ClearCommError(port->portHandle, NULL, &comStat) && comStat.cbInQue > 1)
+                            bytestoread = jmin ((DWORD) chunkSize, comStat.cbInQue);
                         ResetEvent(ovRead.hEvent);
                         //Logger::outputDebugString (" ReadFile");
-                        ReadFile(port->portHandle, &c, 1, &bytesread, &ovRead);
+                        ReadFile(port->portHandle, chunk.getData(), bytestoread, &bytesread, &ovRead);
 //                         if (GetLastError () != ERROR_SUCCESS)
 //                             Logger::outputDebugString (" [SerialPortInputStream, getLastError: " + String (GetLastError ()) + "]");
-                        if (bytesread == 1)
+                        if (bytesread > 0)
                         {
                             //Logger::outputDebugString (" add data to input buffer");
-                            const ScopedLock l(bufferCriticalSection);
-                            buffer.ensureSize(bufferedbytes + 1);
-                            buffer[bufferedbytes] = c;
-                            bufferedbytes++;
-                            if (notify == NOTIFY_ALWAYS || ((notify == NOTIFY_ON_CHAR) && (c == notifyChar)))
-                                sendChangeMessage();
+                            bufferIncoming (chunk.getData(), (int) bytesread);
                         }
                     } while (bytesread);
                 }
@@ -372,12 +386,7 @@ int SerialPortInputStream::read(void *destBuffer, int maxBytesToRead)
     if (!port || port->portHandle == 0)
         return -1;
 
-    const ScopedLock l (bufferCriticalSection);
-    if (maxBytesToRead > bufferedbytes)maxBytesToRead = bufferedbytes;
-    memcpy (destBuffer, buffer.getData (), maxBytesToRead);
-    buffer.removeSection (0, maxBytesToRead);
-    bufferedbytes -= maxBytesToRead;
-    return maxBytesToRead;
+    return buffer.read (destBuffer, maxBytesToRead);
 }
 
 /////////////////////////////////
@@ -448,4 +457,7 @@ bool SerialPortOutputStream::write(const void *dataToWrite, size_t howManyBytes)
     return true;
 }
 
+//========== SerialPortMultiplexer ==========
+void SerialPortMultiplexer::run() {} //isSupported() is false, never started
+
 #endif // JUCE_WIN
@@ -20,6 +20,8 @@ bool SerialPort::setConfig(const SerialPortConfig &) { return false; }
 
 bool SerialPort::getConfig(SerialPortConfig &) { return false; }
 
+bool SerialPort::setReadPolicy(const SerialPortReadPolicy &) { return false; }
+
 //========== SerialPortInputStream ==========
 void SerialPortInputStream::cancel () {}
 
@@ -34,4 +36,7 @@ void SerialPortOutputStream::run() {}
 
 bool SerialPortOutputStream::write(const void*, size_t) { return false; }
 
+//========== SerialPortMultiplexer ==========
+void SerialPortMultiplexer::run() {}
+
 #endif // JUCE_IOS
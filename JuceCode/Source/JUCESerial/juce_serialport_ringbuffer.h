@@ -0,0 +1,125 @@
+/*Lock-free single producer / single consumer byte ring buffer used between the serial reader
+thread (producer) and whoever drains the SerialPortInputStream (consumer).
+
+The read and write positions are free running 32 bit counters, masked into a power of two sized
+block, so neither side ever has to memmove the backlog and a read costs the same no matter how
+much is still queued. Each counter sits on its own cache line so the two threads don't false-share.
+
+The producer never waits: bytes that don't fit are dropped and counted in getOverflowBytes() /
+getOverflowEvents(), which is the only sane thing to do with a serial device that won't stop
+talking just because the GUI thread is busy.
+*/
+
+#ifndef _SERIALPORT_RINGBUFFER_H_
+#define _SERIALPORT_RINGBUFFER_H_
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+class JUCE_API SerialRingBuffer
+{
+public:
+	//capacity is rounded up to the next power of two
+	explicit SerialRingBuffer(uint32_t capacity = 1 << 16) :
+		size(roundUpToPowerOfTwo(capacity)), mask(size - 1), storage(size)
+	{
+	}
+
+	//producer side. returns the number of bytes stored, anything beyond that was dropped
+	int write(const void* data, int numBytes)
+	{
+		const uint32_t writePos = writeIndex.load(std::memory_order_relaxed);
+		const uint32_t readPos = readIndex.load(std::memory_order_acquire);
+		const uint32_t freeSpace = size - (writePos - readPos);
+		const uint32_t toWrite = (uint32_t) numBytes < freeSpace ? (uint32_t) numBytes : freeSpace;
+
+		if (toWrite < (uint32_t) numBytes)
+		{
+			overflowBytes.fetch_add(numBytes - toWrite, std::memory_order_relaxed);
+			overflowEvents.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (toWrite == 0)
+			return 0;
+
+		copyIn(writePos & mask, static_cast<const unsigned char*>(data), toWrite);
+		writeIndex.store(writePos + toWrite, std::memory_order_release);
+		totalWritten.fetch_add(toWrite, std::memory_order_relaxed);
+		return (int) toWrite;
+	}
+
+	//consumer side
+	int read(void* dest, int maxBytes)
+	{
+		const uint32_t readPos = readIndex.load(std::memory_order_relaxed);
+		const uint32_t ready = writeIndex.load(std::memory_order_acquire) - readPos;
+		const uint32_t toRead = (uint32_t) maxBytes < ready ? (uint32_t) maxBytes : ready;
+		if (toRead == 0)
+			return 0;
+
+		copyOut(readPos & mask, static_cast<unsigned char*>(dest), toRead);
+		readIndex.store(readPos + toRead, std::memory_order_release);
+		return (int) toRead;
+	}
+
+	//consumer side. true if byte is somewhere in the queued data
+	bool contains(unsigned char byte) const
+	{
+		const uint32_t readPos = readIndex.load(std::memory_order_relaxed);
+		const uint32_t ready = writeIndex.load(std::memory_order_acquire) - readPos;
+		const uint32_t start = readPos & mask;
+		const uint32_t firstPart = ready < size - start ? ready : size - start;
+		const unsigned char* data = storage.getData();
+		return memchr(data + start, byte, firstPart) != nullptr
+		    || (ready > firstPart && memchr(data, byte, ready - firstPart) != nullptr);
+	}
+
+	int getNumReady() const
+	{
+		return (int) (writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire));
+	}
+	int getFreeSpace() const { return (int) size - getNumReady(); }
+	int getCapacity() const { return (int) size; }
+
+	uint64_t getOverflowBytes() const { return overflowBytes.load(std::memory_order_relaxed); }
+	uint64_t getOverflowEvents() const { return overflowEvents.load(std::memory_order_relaxed); }
+	uint64_t getTotalWritten() const { return totalWritten.load(std::memory_order_relaxed); }
+
+private:
+	static uint32_t roundUpToPowerOfTwo(uint32_t n)
+	{
+		uint32_t p = 1;
+		while (p < n && p < (1u << 31))
+			p <<= 1;
+		return p;
+	}
+
+	void copyIn(uint32_t start, const unsigned char* src, uint32_t numBytes)
+	{
+		const uint32_t firstPart = numBytes < size - start ? numBytes : size - start;
+		memcpy(storage.getData() + start, src, firstPart);
+		memcpy(storage.getData(), src + firstPart, numBytes - firstPart);
+	}
+
+	void copyOut(uint32_t start, unsigned char* dest, uint32_t numBytes) const
+	{
+		const uint32_t firstPart = numBytes < size - start ? numBytes : size - start;
+		memcpy(dest, storage.getData() + start, firstPart);
+		memcpy(dest + firstPart, storage.getData(), numBytes - firstPart);
+	}
+
+	const uint32_t size;
+	const uint32_t mask;
+	juce::HeapBlock<unsigned char> storage;
+
+	alignas(64) std::atomic<uint32_t> writeIndex { 0 };   //only the producer stores
+	alignas(64) std::atomic<uint32_t> readIndex { 0 };    //only the consumer stores
+	alignas(64) std::atomic<uint64_t> overflowBytes { 0 };
+	std::atomic<uint64_t> overflowEvents { 0 };
+	std::atomic<uint64_t> totalWritten { 0 };
+
+	JUCE_DECLARE_NON_COPYABLE (SerialRingBuffer)
+};
+
+#endif //_SERIALPORT_RINGBUFFER_H_
@@ -4,22 +4,45 @@
 // get the serial data parsing to work
 // create sequence type dropdown
 
-enum SensorNums
+// what arduino_analog.ino talks in ASCII mode; binary frames want 115200
+const static int DEFAULT_BAUD_RATE = 9600;
+
+//==============================================================================
+std::unique_ptr<BioSignals::WavetableBank> MainComponent::loadWavetable()
 {
-  TEMP1 = 0x01,
-  TEMP2 = 0x02,
-  PULSE = 0x03,
-  ACCLX = 0x04,
-  ACCLY = 0x05,
-  ACCLZ = 0x06,
-};
+  //BIOSIGNALS_WAVETABLES plays BIOSIGNALS_WAVETABLE (saw unless given) out of
+  //a .bswl library, mapped rather than loaded
+  juce::String library_path = juce::SystemStats::getEnvironmentVariable(
+      "BIOSIGNALS_WAVETABLES", {});
+  if (library_path.isNotEmpty())
+  {
+    juce::String name = juce::SystemStats::getEnvironmentVariable(
+        "BIOSIGNALS_WAVETABLE", "saw");
+    BioSignals::WavetableLibrary library;
+    std::unique_ptr<BioSignals::WavetableBank> bank;
+    if (library.open(juce::File(library_path)))
+      bank = library.getBank(name);
+    if (bank != nullptr)
+    {
+      // here, not on the first note in the audio callback
+      bank->prefault();
+      return bank;
+    }
+    juce::Logger::getCurrentLogger()->writeToLog(
+        "Can't load " + name + " from " + library_path);
+  }
 
-const static float MIN_TEMP = 20.0f;
-const static float MAX_TEMP = 27.0f;
+#if BIOSIGNALS_BAKED_WAVETABLES
+  // Resources/saw.bswt, from `BioSignalsTools bake-wavetables Resources`
+  if (auto bank = BioSignals::WavetableBank::createFromMemory(BinaryData::saw_bswt,
+                                                              (size_t) BinaryData::saw_bswtSize))
+    return bank;
+  jassertfalse; // damaged or from an older format, bake it again
+#endif
+  return BioSignals::WavetableBank::createSaw(8192);
+}
 
-//==============================================================================
-MainComponent::MainComponent() : synth_wavetable_(*wavetable_),
-                                 sequencer_(synth_wavetable_)
+MainComponent::MainComponent()
 {
   // Make sure you set the size of the component after
   // you add any child components.
@@ -48,10 +71,10 @@ MainComponent::MainComponent() : synth_wavetable_(*wavetable_),
   // GUI stuffs
   addAndMakeVisible(&tempoSlider);
   tempoSlider.addListener(this);
-  tempoSlider.setRange(10.0f, 2000.0f);
+  tempoSlider.setRange(BioSignals::SynthEngine::minTempo, BioSignals::SynthEngine::maxTempo);
   
   addAndMakeVisible(&freqSlider);
-  freqSlider.setRange(20.0f, 12000.0f);
+  freqSlider.setRange(BioSignals::SynthEngine::minCutoff, BioSignals::SynthEngine::maxCutoff);
   freqSlider.addListener(this);
   freqLabel.attachToComponent(&freqSlider, true);
 
@@ -66,50 +89,61 @@ MainComponent::MainComponent() : synth_wavetable_(*wavetable_),
     seqTypeDropdown.addItem(e.second, id++);
   seqTypeDropdown.addListener(this);
   seqTypeDropdown.setSelectedId(1);
- 
-  
-  DebugFunction df = [](juce::String a, juce::String b) {
-    juce::Logger* logger = juce::Logger::getCurrentLogger();
-    logger->outputDebugString("---juce_serialport---");
-    logger->outputDebugString("a: " + a);
-    logger->outputDebugString("b: " + b);
-  };
 
-  //open the specified port on the system
-  juce::StringPairArray portlist = SerialPort::getSerialPortPaths();
-  if (portlist.size() == 0)
-    juce::Logger::getCurrentLogger()->writeToLog("No serial ports available");
-  for (const juce::String& key : portlist.getAllKeys()) {
-    juce::Logger::getCurrentLogger()->writeToLog(key);
-  }
-  for (const juce::String& value : portlist.getAllValues()) {
-    juce::Logger::getCurrentLogger()->writeToLog(value);
-  }
+  // readings reach the audio thread on their own, this is just for the sliders
+  sensor_ingest_.addChangeListener(this);
+
+  // cleaned up on the way in, the way the engine expects them
+  BioSignals::SynthEngine::setUpConditioning(sensor_ingest_);
   
-  juce::String selection = getPortBlockingSerialDialog(portlist);
-  juce::Logger::getCurrentLogger()->writeToLog("Selection: " + selection);
-
-  sp = std::unique_ptr<SerialPort>(new SerialPort(
-    "/dev/cu." + selection,
-    SerialPortConfig(9600,
-                     8,
-                     SerialPortConfig::SERIALPORT_PARITY_NONE,
-                     SerialPortConfig::STOPBITS_1,
-                     SerialPortConfig::FLOWCONTROL_NONE),
-    df
-  ));
-  if(sp->exists()) {
-    //create stream for reading
-    instream = std::unique_ptr<SerialPortInputStream>(
-      new SerialPortInputStream(sp.get())
-    );
+  //BIOSIGNALS_RECORD logs every reading of the session, to the given file or
+  //to a new one in the given directory
+  juce::String record_path = juce::SystemStats::getEnvironmentVariable(
+      "BIOSIGNALS_RECORD", {});
+  if (record_path.isNotEmpty())
+  {
+    juce::File record_file(record_path);
+    if (record_file.isDirectory())
+      record_file = BioSignals::SensorRecorder::createSessionFile(record_file);
+    recorder_ = std::unique_ptr<BioSignals::SensorRecorder>(new BioSignals::SensorRecorder());
+    if (recorder_->start(record_file))
+    {
+      sensor_dispatch_.setTap([this] (const BioSignals::SensorEvent* events, int num_events) {
+        recorder_->push(events, num_events);
+      });
+      juce::Logger::getCurrentLogger()->writeToLog("recording to " + record_file.getFullPathName());
+    }
+    else
+    {
+      juce::Logger::getCurrentLogger()->writeToLog("Can't record to " + record_file.getFullPathName());
+    }
+  }
 
-    //ask to be notified whenever any character is received
-    instream->addChangeListener(this);
-    instream->setNotify(SerialPortInputStream::NOTIFY_ON_CHAR, '\n');
-    juce::Logger::getCurrentLogger()->writeToLog("opened serial port");
-  } else {
-    juce::Logger::getCurrentLogger()->writeToLog("NO SERIAL PORT FOUND!!!");
+  //BIOSIGNALS_REPLAY plays a recorded session instead of opening any ports,
+  //from BIOSIGNALS_REPLAY_FROM seconds in at BIOSIGNALS_REPLAY_SPEED
+  juce::String replay_path = juce::SystemStats::getEnvironmentVariable(
+      "BIOSIGNALS_REPLAY", {});
+  if (replay_path.isEmpty())
+  {
+    openSerialPorts();
+  }
+  else
+  {
+    player_ = std::unique_ptr<BioSignals::SensorLogPlayer>(
+        new BioSignals::SensorLogPlayer(sensor_ingest_));
+    if (player_->open(juce::File(replay_path)))
+    {
+      player_->play(
+          1000.0 * juce::SystemStats::getEnvironmentVariable(
+              "BIOSIGNALS_REPLAY_FROM", "0").getDoubleValue(),
+          juce::SystemStats::getEnvironmentVariable(
+              "BIOSIGNALS_REPLAY_SPEED", "1").getDoubleValue());
+      juce::Logger::getCurrentLogger()->writeToLog("replaying " + replay_path);
+    }
+    else
+    {
+      juce::Logger::getCurrentLogger()->writeToLog("Can't replay " + replay_path);
+    }
   }
 }
 
@@ -121,13 +155,8 @@ MainComponent::~MainComponent()
 //==============================================================================
 void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
-  low_pass_filter_ch1.setCoefficients(
-      juce::IIRCoefficients::makeLowPass(sampleRate, 1000.0f)
-  );
-  low_pass_filter_ch2.setCoefficients(
-      juce::IIRCoefficients::makeLowPass(sampleRate, 1000.0f)
-  );
-  sequencer_.setSequence(
+  sample_rate = sampleRate;
+  engine_.getSequencer().setSequence(
     new BioSignals::FreqRandom((std::vector<juce::uint8>) {
       60,
       62,
@@ -138,7 +167,7 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
       71,
       72
     }));
-  sequencer_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+  engine_.prepareToPlay(samplesPerBlockExpected, sampleRate);
 
   juce::String message;
   message << "Preparing to play audio with ";
@@ -149,24 +178,12 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
 
 void MainComponent::getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill)
 {
-  sequencer_.getNextAudioBlock(bufferToFill);
-
-  auto* ch1_buffer = bufferToFill.buffer->getWritePointer(0);
-  auto* ch2_buffer = bufferToFill.buffer->getWritePointer(1);
-  
-  for (unsigned int idx = 0; idx < bufferToFill.numSamples; ++idx)
-  {
-    ch1_buffer[idx] *= volume;
-    ch2_buffer[idx] *= volume;
-  }
-
-  low_pass_filter_ch1.processSamples(ch1_buffer, bufferToFill.numSamples);
-  low_pass_filter_ch2.processSamples(ch2_buffer, bufferToFill.numSamples);
+  engine_.getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
 {
-  sequencer_.releaseResources();
+  engine_.releaseResources();
   juce::Logger::getCurrentLogger()->writeToLog("Releasing resources");
 }
 
@@ -193,53 +210,42 @@ void MainComponent::resized()
 }
 
 void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source) {
-  if (source == instream.get()) { // source is the serial input stream
-    juce::String line = instream->readNextLine();
-    juce::Logger::getCurrentLogger()->writeToLog(line);
-    auto* buf = line.getCharPointer().getAddress();
-    buf[line.length()] = '\0';
-    juce::uint8 sensor_num = buf[0] - 48;
-//    juce::Logger::getCurrentLogger()->outputDebugString("sensor_num: " + std::to_string(sensor_num));
-
-    float new_val = strtof(buf + 1, NULL);
-//    juce::Logger::getCurrentLogger()->outputDebugString("new value: " + std::to_string(new_val));
-    
-    if (sensor_num == TEMP2)
-    {
-      freqSlider.setValue(
-          ((new_val - MIN_TEMP) / (MAX_TEMP - MIN_TEMP)) *
-           (freqSlider.getMaximum() - freqSlider.getMinimum()) +
-          freqSlider.getMinimum());
-    }
-    else if (sensor_num == PULSE)
-    {
-//      juce::Logger::getCurrentLogger()->outputDebugString("PULSE");
-      tempoSlider.setValue(new_val);
-    }
+  if (source == &sensor_ingest_) {
+    sensor_dispatch_.dispatch();
   } else {
 //    juce::Logger::getCurrentLogger()->writeToLog("CALLBACK");
     updateSequence(seqTypeDropdown.getSelectedId() - 1);
   }
 }
 
+void MainComponent::showSensorEvent(const BioSignals::SensorEvent& event)
+{
+  if (event.device != 0)
+    return; // the sliders show the board that drives the synth
+
+  // the audio thread already has these, so don't send them round again. show
+  // the conditioned value it's playing rather than the raw reading
+  const auto& values = sensor_ingest_.getValues(event.device);
+  const int sensor = event.record.sensor;
+  if (sensor == BioSignals::TEMP2)
+    freqSlider.setValue(BioSignals::SynthEngine::temperatureToCutoff(values.getValue(sensor)), juce::dontSendNotification);
+  else if (sensor == BioSignals::PULSE)
+    tempoSlider.setValue(BioSignals::SynthEngine::pulseToTempo(values.getValue(sensor)), juce::dontSendNotification);
+}
+
 void MainComponent::sliderValueChanged(juce::Slider* slider_source)
 {
   if (slider_source == &freqSlider)
   {
-    low_pass_filter_ch1.setCoefficients(
-        juce::IIRCoefficients::makeLowPass(sample_rate, freqSlider.getValue())
-    );
-    low_pass_filter_ch2.setCoefficients(
-        juce::IIRCoefficients::makeLowPass(sample_rate, freqSlider.getValue())
-    );
+    engine_.getParameters().setTarget(BioSignals::CUTOFF_OCTAVES, std::log2((float) freqSlider.getValue()));
   }
   else if (slider_source == &tempoSlider)
   {
-    sequencer_.setTempo(tempoSlider.getValue());
+    engine_.getParameters().setTarget(BioSignals::TEMPO, (float) tempoSlider.getValue());
   }
   else if (slider_source == &volumeSlider)
   {
-    volume = volumeSlider.getValue();
+    engine_.getParameters().setTarget(BioSignals::VOLUME, (float) volumeSlider.getValue());
   }
 }
 
@@ -284,9 +290,101 @@ juce::String MainComponent::getPortBlockingSerialDialog(
   return choice;
 }
 
+void MainComponent::openSerialPorts()
+{
+  DebugFunction df = [](juce::String a, juce::String b) {
+    juce::Logger* logger = juce::Logger::getCurrentLogger();
+    logger->outputDebugString("---juce_serialport---");
+    logger->outputDebugString("a: " + a);
+    logger->outputDebugString("b: " + b);
+  };
+
+  //open the specified port on the system. BIOSIGNALS_SERIAL_PORT skips the
+  //dialog, e.g. to point us at a pty from the sensor simulator. a comma
+  //separated list opens one board per performer; the first drives the synth
+  juce::StringArray port_paths = juce::StringArray::fromTokens(
+      juce::SystemStats::getEnvironmentVariable("BIOSIGNALS_SERIAL_PORT", {}), ",", "");
+  port_paths.trim();
+  port_paths.removeEmptyStrings();
+  if (port_paths.isEmpty())
+  {
+    juce::StringPairArray portlist = SerialPort::getSerialPortPaths();
+    if (portlist.size() == 0)
+      juce::Logger::getCurrentLogger()->writeToLog("No serial ports available");
+    for (const juce::String& key : portlist.getAllKeys()) {
+      juce::Logger::getCurrentLogger()->writeToLog(key);
+    }
+    for (const juce::String& value : portlist.getAllValues()) {
+      juce::Logger::getCurrentLogger()->writeToLog(value);
+    }
+
+    juce::String selection = getPortBlockingSerialDialog(portlist);
+    juce::Logger::getCurrentLogger()->writeToLog("Selection: " + selection);
+#if JUCE_MAC
+    // the callout device; the dialin one we're given blocks in open() until DCD
+    port_paths.add("/dev/cu." + selection);
+#else
+    port_paths.add(portlist[selection]);
+#endif
+  }
+
+  const int baud_rate = juce::SystemStats::getEnvironmentVariable(
+      "BIOSIGNALS_SERIAL_BAUD", juce::String(DEFAULT_BAUD_RATE)).getIntValue();
+
+  for (const juce::String& port_path : port_paths)
+  {
+    if (ports_.size() == BioSignals::maxSensorDevices)
+    {
+      juce::Logger::getCurrentLogger()->writeToLog("Too many serial ports, ignoring " + port_path);
+      continue;
+    }
+    std::unique_ptr<SerialPort> port(new SerialPort(
+      port_path,
+      SerialPortConfig(baud_rate,
+                       8,
+                       SerialPortConfig::SERIALPORT_PARITY_NONE,
+                       SerialPortConfig::STOPBITS_1,
+                       SerialPortConfig::FLOWCONTROL_NONE),
+      df
+    ));
+    if (port->exists())
+      ports_.push_back(std::move(port));
+    else
+      juce::Logger::getCurrentLogger()->writeToLog("Can't open serial port " + port_path);
+  }
+
+  //decode on the reader thread, straight into the values the audio thread
+  //reads, so a busy message thread can't hold the sound back
+  if (ports_.size() > 1 && SerialPortMultiplexer::isSupported()) {
+    //one thread for the lot, each board's bytes tagged with its index
+    serial_mux_ = std::unique_ptr<SerialPortMultiplexer>(new SerialPortMultiplexer(
+      [this] (int device, const unsigned char* data, int num_bytes) {
+        sensor_ingest_.handleBytes(device, data, num_bytes);
+      }
+    ));
+    for (auto& port : ports_)
+      serial_mux_->addPort(port.get());
+    serial_mux_->start();
+    juce::Logger::getCurrentLogger()->writeToLog(
+        "opened " + juce::String((int) ports_.size()) + " serial ports");
+  } else if (!ports_.empty()) {
+    if (ports_.size() > 1)
+      juce::Logger::getCurrentLogger()->writeToLog("Only reading the first serial port here");
+    instream = std::unique_ptr<SerialPortInputStream>(
+      new SerialPortInputStream(ports_.front().get(),
+                                [this] (const unsigned char* data, int num_bytes) {
+                                  sensor_ingest_.handleBytes(data, num_bytes);
+                                })
+    );
+    juce::Logger::getCurrentLogger()->writeToLog("opened serial port");
+  } else {
+    juce::Logger::getCurrentLogger()->writeToLog("NO SERIAL PORT FOUND!!!");
+  }
+}
+
 void MainComponent::updateSequence(unsigned int new_seq_idx)
 {
-  sequencer_
+  engine_.getSequencer()
     .setSequence(
         constructFreqGenerator(
             BioSignals::generator_types[new_seq_idx].first,
@@ -2,9 +2,11 @@
 
 #include <JuceHeader.h>
 #include "JUCESerial/juce_serialport.h"
+#include "SensorDispatch.h"
+#include "SensorReplay.h"
 #include "SequenceEditor.h"
-#include "Sequencer.h"
-#include "WavetableOsc.h"
+#include "SynthEngine.h"
+#include "WavetableLibrary.h"
 
 //==============================================================================
 /*
@@ -36,14 +38,14 @@ public:
 
 private:
   juce::String getPortBlockingSerialDialog(const juce::StringPairArray& portlist);
+  void openSerialPorts();
   void updateSequence(unsigned int new_seq_idx);
+  void showSensorEvent(const BioSignals::SensorEvent& event); // message thread
+  static std::unique_ptr<BioSignals::WavetableBank> loadWavetable();
   //==============================================================================
-  std::unique_ptr<juce::AudioSampleBuffer> wavetable_ =
-          BioSignals::WavetableOscillator::createWavetableBLITSaw(8192, 27);
-  BioSignals::WavetableOscillator synth_wavetable_;
-  BioSignals::Sequencer sequencer_;
-  juce::IIRFilter low_pass_filter_ch1;
-  juce::IIRFilter low_pass_filter_ch2;
+  std::unique_ptr<BioSignals::WavetableBank> wavetable_ = loadWavetable();
+  BioSignals::SensorIngest sensor_ingest_;
+  BioSignals::SynthEngine engine_ { *wavetable_, &sensor_ingest_ };
 
   BioSignals::SequenceEditor sequence_editor_;
   
@@ -59,11 +61,17 @@ private:
 
   juce::Label volumeLabel;
 
-  float volume = 0.0f;
   double sample_rate = 48000.0;
 
-  std::unique_ptr<SerialPort> sp;
+  BioSignals::SensorDispatcher sensor_dispatch_ {
+      sensor_ingest_, [this] (const BioSignals::SensorEvent& event) { showSensorEvent(event); } };
+  std::unique_ptr<BioSignals::SensorRecorder> recorder_;
+  std::unique_ptr<BioSignals::SensorLogPlayer> player_; // feeds sensor_ingest_ instead of the ports
+
+  std::vector<std::unique_ptr<SerialPort>> ports_;
+  // after sensor_ingest_ and ports_, their threads use both
   std::unique_ptr<SerialPortInputStream> instream;
+  std::unique_ptr<SerialPortMultiplexer> serial_mux_;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
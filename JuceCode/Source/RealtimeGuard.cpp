@@ -0,0 +1,415 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+
+  ==============================================================================
+*/
+
+// the hooks below define read() and poll() themselves, which fortified
+// headers would otherwise have already defined inline
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeGuard.h"
+#include <algorithm>
+#include <atomic>
+
+#if BIOSIGNALS_REALTIME_CHECKS && defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <fcntl.h>
+ #include <poll.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <sys/select.h>
+ #include <unistd.h>
+ #include <cerrno>
+ #include <cstdarg>
+ #include <ctime>
+#elif BIOSIGNALS_REALTIME_CHECKS
+ #include <cstdlib>
+ #include <new>
+#endif
+
+namespace BioSignals
+{
+
+#if BIOSIGNALS_REALTIME_CHECKS
+
+namespace
+{
+
+// how many sections deep this thread is, and whether it's in the middle of
+// reporting one, in which case whatever the report does itself passes through
+thread_local int sectionDepth = 0;
+thread_local bool reporting = false;
+
+std::atomic<int> numViolations { 0 };
+std::atomic<bool> logging { true };
+
+juce::CriticalSection& getLock()
+{
+  static juce::CriticalSection lock;
+  return lock;
+}
+
+std::vector<RealtimeGuard::Violation>& getSeen()
+{
+  static std::vector<RealtimeGuard::Violation> seen;
+  return seen;
+}
+
+void report(const char* what)
+{
+  // first in, so it's still set while the locals below are freed
+  const juce::ScopedValueSetter<bool> passThrough(reporting, true);
+  ++numViolations;
+
+  const juce::String stackTrace = juce::SystemStats::getStackBacktrace();
+  bool isNew = false;
+  {
+    const juce::ScopedLock lock(getLock());
+    auto& seen = getSeen();
+    auto found = std::find_if(seen.begin(), seen.end(),
+                              [&](const RealtimeGuard::Violation& violation)
+                              {
+                                return violation.stackTrace == stackTrace
+                                    && violation.what == what;
+                              });
+    if (found != seen.end())
+      ++found->count;
+    else
+    {
+      seen.push_back({ what, stackTrace, 1 });
+      isNew = true;
+    }
+  }
+
+  if (isNew && logging)
+    juce::Logger::writeToLog(juce::String("real time violation, ") + what
+                             + " on the audio thread, from:\n" + stackTrace);
+}
+
+/** What every hook calls before passing through */
+void checkRealtime(const char* what)
+{
+  if (sectionDepth > 0 && !reporting)
+    report(what);
+}
+
+} // namespace
+
+ScopedRealtimeSection::ScopedRealtimeSection() noexcept
+{
+  ++sectionDepth;
+}
+
+ScopedRealtimeSection::~ScopedRealtimeSection() noexcept
+{
+  --sectionDepth;
+}
+
+std::vector<RealtimeGuard::Violation> RealtimeGuard::getViolations()
+{
+  const juce::ScopedLock lock(getLock());
+  return getSeen();
+}
+
+int RealtimeGuard::getNumViolations() noexcept
+{
+  return numViolations;
+}
+
+void RealtimeGuard::reset()
+{
+  const juce::ScopedLock lock(getLock());
+  getSeen().clear();
+  numViolations = 0;
+}
+
+void RealtimeGuard::setLogging(bool shouldLog) noexcept
+{
+  logging = shouldLog;
+}
+
+#else
+
+std::vector<RealtimeGuard::Violation> RealtimeGuard::getViolations()
+{
+  return {};
+}
+
+int RealtimeGuard::getNumViolations() noexcept
+{
+  return 0;
+}
+
+void RealtimeGuard::reset()
+{ /* Nothing */ }
+
+void RealtimeGuard::setLogging(bool) noexcept
+{ /* Nothing */ }
+
+#endif
+
+} // namespace BioSignals
+
+#if BIOSIGNALS_REALTIME_CHECKS && defined(__GLIBC__)
+//==============================================================================
+// Defined in the executable, these win over the C library's for every caller
+// in the process, shared libraries included. The allocator passes through to
+// the names glibc keeps its own under, everything else to whatever dlsym()
+// finds next.
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+extern "C" void __libc_free(void* block);
+
+namespace
+{
+
+template <typename Function>
+Function* findNext(const char* name) noexcept
+{
+  return reinterpret_cast<Function*>(dlsym(RTLD_NEXT, name));
+}
+
+} // namespace
+
+extern "C"
+{
+
+void* malloc(size_t size)
+{
+  BioSignals::checkRealtime("malloc");
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+  BioSignals::checkRealtime("calloc");
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* block, size_t size)
+{
+  BioSignals::checkRealtime("realloc");
+  return __libc_realloc(block, size);
+}
+
+void free(void* block)
+{
+  if (block != nullptr)
+    BioSignals::checkRealtime("free");
+  __libc_free(block);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+  BioSignals::checkRealtime("memalign");
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+  BioSignals::checkRealtime("aligned_alloc");
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** block, size_t alignment, size_t size)
+{
+  BioSignals::checkRealtime("posix_memalign");
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  void* aligned = __libc_memalign(alignment, size);
+  if (aligned == nullptr)
+    return ENOMEM;
+  *block = aligned;
+  return 0;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+  static auto* const next = findNext<decltype(pthread_mutex_lock)>("pthread_mutex_lock");
+  BioSignals::checkRealtime("pthread_mutex_lock");
+  return next(mutex);
+}
+
+int pthread_mutex_timedlock(pthread_mutex_t* mutex, const timespec* timeout)
+{
+  static auto* const next = findNext<decltype(pthread_mutex_timedlock)>("pthread_mutex_timedlock");
+  BioSignals::checkRealtime("pthread_mutex_timedlock");
+  return next(mutex, timeout);
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t* lock)
+{
+  static auto* const next = findNext<decltype(pthread_rwlock_rdlock)>("pthread_rwlock_rdlock");
+  BioSignals::checkRealtime("pthread_rwlock_rdlock");
+  return next(lock);
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t* lock)
+{
+  static auto* const next = findNext<decltype(pthread_rwlock_wrlock)>("pthread_rwlock_wrlock");
+  BioSignals::checkRealtime("pthread_rwlock_wrlock");
+  return next(lock);
+}
+
+int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+{
+  static auto* const next = findNext<decltype(pthread_cond_wait)>("pthread_cond_wait");
+  BioSignals::checkRealtime("pthread_cond_wait");
+  return next(condition, mutex);
+}
+
+int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex,
+                           const timespec* timeout)
+{
+  static auto* const next = findNext<decltype(pthread_cond_timedwait)>("pthread_cond_timedwait");
+  BioSignals::checkRealtime("pthread_cond_timedwait");
+  return next(condition, mutex, timeout);
+}
+
+int sem_wait(sem_t* semaphore)
+{
+  static auto* const next = findNext<decltype(sem_wait)>("sem_wait");
+  BioSignals::checkRealtime("sem_wait");
+  return next(semaphore);
+}
+
+int sem_timedwait(sem_t* semaphore, const timespec* timeout)
+{
+  static auto* const next = findNext<decltype(sem_timedwait)>("sem_timedwait");
+  BioSignals::checkRealtime("sem_timedwait");
+  return next(semaphore, timeout);
+}
+
+int open(const char* path, int flags, ...)
+{
+  static auto* const next = findNext<decltype(open)>("open");
+  BioSignals::checkRealtime("open");
+
+  // only these two take a mode
+  mode_t mode = 0;
+  if ((flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE)
+  {
+    va_list args;
+    va_start(args, flags);
+    mode = (mode_t) va_arg(args, int);
+    va_end(args);
+  }
+  return next(path, flags, mode);
+}
+
+ssize_t read(int fd, void* buffer, size_t count)
+{
+  static auto* const next = findNext<decltype(read)>("read");
+  BioSignals::checkRealtime("read");
+  return next(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count)
+{
+  static auto* const next = findNext<decltype(write)>("write");
+  BioSignals::checkRealtime("write");
+  return next(fd, buffer, count);
+}
+
+int fsync(int fd)
+{
+  static auto* const next = findNext<decltype(fsync)>("fsync");
+  BioSignals::checkRealtime("fsync");
+  return next(fd);
+}
+
+int poll(pollfd* fds, nfds_t numFds, int timeoutMs)
+{
+  static auto* const next = findNext<decltype(poll)>("poll");
+  BioSignals::checkRealtime("poll");
+  return next(fds, numFds, timeoutMs);
+}
+
+int select(int numFds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, timeval* timeout)
+{
+  static auto* const next = findNext<decltype(select)>("select");
+  BioSignals::checkRealtime("select");
+  return next(numFds, readFds, writeFds, exceptFds, timeout);
+}
+
+int nanosleep(const timespec* duration, timespec* remaining)
+{
+  static auto* const next = findNext<decltype(nanosleep)>("nanosleep");
+  BioSignals::checkRealtime("nanosleep");
+  return next(duration, remaining);
+}
+
+int clock_nanosleep(clockid_t clock, int flags, const timespec* duration, timespec* remaining)
+{
+  static auto* const next = findNext<decltype(clock_nanosleep)>("clock_nanosleep");
+  BioSignals::checkRealtime("clock_nanosleep");
+  return next(clock, flags, duration, remaining);
+}
+
+int usleep(useconds_t microseconds)
+{
+  static auto* const next = findNext<decltype(usleep)>("usleep");
+  BioSignals::checkRealtime("usleep");
+  return next(microseconds);
+}
+
+} // extern "C"
+
+#elif BIOSIGNALS_REALTIME_CHECKS
+//==============================================================================
+// Without glibc there's no portable way in under malloc, but everything this
+// app allocates itself goes through these
+
+void* operator new(std::size_t size)
+{
+  BioSignals::checkRealtime("operator new");
+  if (void* block = std::malloc(size == 0 ? 1 : size))
+    return block;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  BioSignals::checkRealtime("operator new");
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+  return operator new(size, tag);
+}
+
+void operator delete(void* block) noexcept
+{
+  if (block != nullptr)
+    BioSignals::checkRealtime("operator delete");
+  std::free(block);
+}
+
+void operator delete[](void* block) noexcept
+{
+  operator delete(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept
+{
+  operator delete(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept
+{
+  operator delete(block);
+}
+
+#endif
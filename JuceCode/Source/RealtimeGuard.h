@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+// Debug builds of the app and the tools turn this on in their .jucer files
+#ifndef BIOSIGNALS_REALTIME_CHECKS
+ #define BIOSIGNALS_REALTIME_CHECKS 0
+#endif
+
+namespace BioSignals
+{
+
+/**
+ Catches the audio thread doing what it mustn't: allocating or freeing memory,
+ taking a lock or waiting on a condition, or making a system call that can
+ block, like a read, a write or a sleep. Any of those can stall it long
+ enough to drop out, and none of them show up in a profile until they do.
+
+ Built with BIOSIGNALS_REALTIME_CHECKS, the executable replaces malloc and
+ friends, the pthread lock and wait calls, and the blocking system calls
+ with ones that check whether the calling thread is inside a
+ ScopedRealtimeSection before passing through to the C library. Each one
+ that is counts as a violation and is kept, with a stack trace, the first
+ time it comes from a given place. On Linux with glibc all of that is
+ covered. Elsewhere, macOS included, only operator new and delete are: a
+ direct malloc(), a lock, a wait or a system call on the audio thread goes
+ by unseen there.
+
+ SynthEngine::getNextAudioBlock() is a section, so the app checks the live
+ callback and `BioSignalsTools render --check-realtime` checks the same code
+ offline, failing if anything turns up.
+
+ Built without it, a section is an empty object and nothing is hooked.
+ */
+namespace RealtimeGuard
+{
+  struct Violation
+  {
+    juce::String what;        // the call that was made, e.g. "malloc"
+    juce::String stackTrace;  // from where, the first time
+    int count = 0;            // and how many times from there since
+  };
+
+  /** Whether this build can catch anything at all */
+  constexpr bool isAvailable() noexcept { return BIOSIGNALS_REALTIME_CHECKS != 0; }
+
+  /** Every distinct violation so far, in the order they were first seen */
+  std::vector<Violation> getViolations();
+
+  /** All of them, repeats included */
+  int getNumViolations() noexcept;
+
+  /** Forgets every violation so far */
+  void reset();
+
+  /** Whether each new violation also goes to the Logger. On by default */
+  void setLogging(bool shouldLog) noexcept;
+}
+
+/**
+ Marks the calling thread as the audio thread for as long as it's in scope.
+ Sections nest. Put one at the top of a callback.
+ */
+class ScopedRealtimeSection
+{
+public:
+#if BIOSIGNALS_REALTIME_CHECKS
+  ScopedRealtimeSection() noexcept;
+  ~ScopedRealtimeSection() noexcept;
+#else
+  ScopedRealtimeSection() noexcept {}
+#endif
+
+  JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+};
+
+} // namespace BioSignals
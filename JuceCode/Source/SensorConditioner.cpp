@@ -0,0 +1,280 @@
+/*
+  ==============================================================================
+
+    SensorConditioner.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorConditioner.h"
+
+namespace BioSignals
+{
+
+/** Smoothing factor of a one pole low pass at cutoffHz, run every periodSeconds */
+static float lowPassAlpha(float cutoffHz, double periodSeconds) noexcept
+{
+  const double tau = 1.0 / (juce::MathConstants<double>::twoPi * cutoffHz);
+  return (float) (1.0 / (1.0 + tau / periodSeconds));
+}
+
+SensorConditioner::SensorConditioner(double controlRateHz)
+{
+  setControlRate(controlRateHz);
+}
+
+void SensorConditioner::setControlRate(double controlRateHz)
+{
+  jassert(controlRateHz > 0.0);
+  controlRateHz_ = controlRateHz;
+  periodMs_ = 1000.0 / controlRateHz;
+  for (auto& channel : channels_)
+    prepare(channel);
+}
+
+void SensorConditioner::setChain(int sensor, const ConditioningChain& chain)
+{
+  jassert(sensor >= 0 && sensor < numSensorIds);
+  jassert(chain.medianLength >= 1 && chain.medianLength <= maxMedianLength
+          && chain.medianLength % 2 == 1);
+  auto& channel = channels_[sensor];
+  channel.enabled = true;
+  channel.chain = chain;
+  channel.chain.medianLength = juce::jlimit(1, maxMedianLength, chain.medianLength | 1);
+  prepare(channel);
+  clear(channel);
+}
+
+void SensorConditioner::clearChain(int sensor)
+{
+  channels_[sensor].enabled = false;
+  clear(channels_[sensor]);
+}
+
+void SensorConditioner::reset() noexcept
+{
+  for (auto& channel : channels_)
+    clear(channel);
+}
+
+void SensorConditioner::prepare(Channel& channel) noexcept
+{
+  const auto& chain = channel.chain;
+  channel.emaAlpha = (float) (1.0 - std::exp(-periodMs_ / juce::jmax(1.0e-3f, chain.emaTimeConstantMs)));
+  channel.maxStep = (float) (chain.maxSlewPerSecond * periodMs_ / 1000.0);
+}
+
+void SensorConditioner::clear(Channel& channel) noexcept
+{
+  channel.historyLength = 0;
+  channel.historyPos = 0;
+  channel.started = false;
+  channel.rejected = 0;
+}
+
+int SensorConditioner::process(const SensorRecord* records, int numRecords,
+                               double hostTimeMs, SensorRecord* out) noexcept
+{
+  int numOut = 0;
+  bool anyChains = false;
+  for (int idx = 0; idx < numRecords; ++idx)
+  {
+    const int sensor = records[idx].sensor;
+    if (sensor < numSensorIds && channels_[sensor].enabled)
+      anyChains = true;
+    else
+      out[numOut++] = records[idx];
+  }
+  if (!anyChains)
+    return numOut;
+
+  float values[blockSize];
+  double times[blockSize];
+  for (int sensor = 0; sensor < numSensorIds; ++sensor)
+  {
+    auto& channel = channels_[sensor];
+    if (!channel.enabled)
+      continue;
+
+    bool haveOutput = false;
+    juce::uint32 deviceTime = 0;
+    for (int offset = 0; offset < numRecords; offset += blockSize)
+    {
+      const int count = juce::jmin(blockSize, numRecords - offset);
+      const int numValues = gather(sensor, records + offset, count, hostTimeMs,
+                                   values, times, deviceTime);
+      if (numValues == 0)
+        continue;
+
+      rejectOutliers(channel, values, numValues);
+      haveOutput = resample(channel, values, times, numValues) || haveOutput;
+    }
+
+    if (haveOutput)
+      out[numOut++] = { (juce::uint8) sensor, channel.slewed, deviceTime };
+  }
+  return numOut;
+}
+
+int SensorConditioner::gather(int sensor, const SensorRecord* records, int numRecords,
+                              double hostTimeMs, float* values, double* times,
+                              juce::uint32& deviceTime) const noexcept
+{
+  int numValues = 0;
+  for (int idx = 0; idx < numRecords; ++idx)
+  {
+    if (records[idx].sensor != sensor)
+      continue;
+    values[numValues] = records[idx].value;
+    times[numValues] = records[idx].deviceTime != 0 ? (double) records[idx].deviceTime
+                                                   : hostTimeMs;
+    deviceTime = records[idx].deviceTime;
+    ++numValues;
+  }
+  return numValues;
+}
+
+void SensorConditioner::rejectOutliers(Channel& channel, float* values, int numValues) noexcept
+{
+  const int length = channel.chain.medianLength;
+  if (length <= 1)
+    return;
+
+  const float threshold = channel.chain.outlierThreshold;
+  float sorted[maxMedianLength];
+  for (int idx = 0; idx < numValues; ++idx)
+  {
+    channel.history[channel.historyPos] = values[idx];
+    channel.historyPos = (channel.historyPos + 1) % length;
+    channel.historyLength = juce::jmin(channel.historyLength + 1, length);
+
+    // insertion sort, there are at most maxMedianLength of them
+    for (int pos = 0; pos < channel.historyLength; ++pos)
+    {
+      const float value = channel.history[pos];
+      int slot = pos;
+      for (; slot > 0 && sorted[slot - 1] > value; --slot)
+        sorted[slot] = sorted[slot - 1];
+      sorted[slot] = value;
+    }
+    const float median = sorted[channel.historyLength / 2];
+
+    if (threshold <= 0.0f)
+    {
+      values[idx] = median;
+    }
+    else if (std::abs(values[idx] - median) > threshold)
+    {
+      values[idx] = median;
+      ++channel.rejected;
+    }
+  }
+}
+
+bool SensorConditioner::resample(Channel& channel, const float* values,
+                                 const double* times, int numValues) noexcept
+{
+  float grid[blockSize];
+  int numGrid = 0;
+  bool haveOutput = false;
+
+  auto flush = [&]
+  {
+    smooth(channel, grid, numGrid);
+    limitSlew(channel, grid, numGrid);
+    haveOutput = haveOutput || numGrid > 0;
+    numGrid = 0;
+  };
+
+  for (int idx = 0; idx < numValues; ++idx)
+  {
+    const double time = times[idx];
+    const float value = values[idx];
+    const double dt = time - channel.lastTime;
+
+    if (!channel.started)
+    {
+      channel.smoothed = channel.lastInput = channel.slewed = value;
+      channel.derivative = 0.0f;
+      channel.started = true;
+      channel.nextTick = time;
+    }
+    else if (dt < 0.0 || dt > maxGapMs)
+    {
+      // back after a dropout, or the clock changed under us: start the grid again
+      channel.nextTick = time;
+    }
+    else if (dt > 0.0)
+    {
+      // ticks since the last reading, interpolated towards this one
+      for (; channel.nextTick < time; channel.nextTick += periodMs_)
+      {
+        const float fraction = (float) ((channel.nextTick - channel.lastTime) / dt);
+        grid[numGrid++] = channel.lastValue + (value - channel.lastValue) * fraction;
+        if (numGrid == blockSize)
+          flush();
+      }
+    }
+
+    if (channel.nextTick <= time)
+    {
+      grid[numGrid++] = value;
+      channel.nextTick += periodMs_;
+      if (numGrid == blockSize)
+        flush();
+    }
+    channel.lastTime = time;
+    channel.lastValue = value;
+  }
+
+  flush();
+  return haveOutput;
+}
+
+void SensorConditioner::smooth(Channel& channel, float* grid, int numSamples) noexcept
+{
+  const auto& chain = channel.chain;
+  if (chain.smoothing == ConditioningChain::EMA)
+  {
+    const float alpha = channel.emaAlpha;
+    float smoothed = channel.smoothed;
+    for (int idx = 0; idx < numSamples; ++idx)
+      grid[idx] = smoothed += alpha * (grid[idx] - smoothed);
+    channel.smoothed = smoothed;
+  }
+  else if (chain.smoothing == ConditioningChain::ONE_EURO)
+  {
+    // Casiez et al., the 1 euro filter: a low pass whose cutoff opens up
+    // with the speed of the signal, so it's smooth at rest and quick to follow
+    const double periodSeconds = periodMs_ / 1000.0;
+    const float derivativeAlpha = lowPassAlpha(chain.derivativeCutoffHz, periodSeconds);
+    for (int idx = 0; idx < numSamples; ++idx)
+    {
+      const float rate = (grid[idx] - channel.lastInput) * (float) controlRateHz_;
+      channel.lastInput = grid[idx];
+      channel.derivative += derivativeAlpha * (rate - channel.derivative);
+      const float cutoff = chain.minCutoffHz + chain.beta * std::abs(channel.derivative);
+      channel.smoothed += lowPassAlpha(cutoff, periodSeconds) * (grid[idx] - channel.smoothed);
+      grid[idx] = channel.smoothed;
+    }
+  }
+}
+
+void SensorConditioner::limitSlew(Channel& channel, float* grid, int numSamples) noexcept
+{
+  const float maxStep = channel.maxStep;
+  float slewed = channel.slewed;
+  if (maxStep <= 0.0f)
+  {
+    if (numSamples > 0)
+      slewed = grid[numSamples - 1];
+  }
+  else
+  {
+    for (int idx = 0; idx < numSamples; ++idx)
+      grid[idx] = slewed += juce::jlimit(-maxStep, maxStep, grid[idx] - slewed);
+  }
+  channel.slewed = slewed;
+}
+
+} // namespace BioSignals
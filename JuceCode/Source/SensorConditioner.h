@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    SensorConditioner.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorParser.h"
+
+namespace BioSignals
+{
+
+/** What a SensorConditioner does to one sensor, stage by stage. Defaults do nothing */
+struct ConditioningChain
+{
+  enum Smoothing
+  {
+    NO_SMOOTHING,
+    EMA,
+    ONE_EURO
+  };
+
+  /** Median over this many readings, odd and at most maxMedianLength; 1 is off */
+  int medianLength = 1;
+  /**
+   With a median, only readings further than this from it are replaced, so
+   good readings go through untouched. 0 always takes the median
+   */
+  float outlierThreshold = 0.0f;
+
+  Smoothing smoothing = NO_SMOOTHING;
+  float emaTimeConstantMs = 100.0f;
+  float minCutoffHz = 1.0f;         // one-euro cutoff while the value holds still
+  float beta = 0.0f;                // how far the cutoff opens per unit/s of change
+  float derivativeCutoffHz = 1.0f;  // smoothing of that change rate
+
+  /** Fastest the output may move, in sensor units per second; 0 is off */
+  float maxSlewPerSecond = 0.0f;
+};
+
+/**
+ Cleans up the readings of one device before they reach the synth.
+
+ Each sensor with a chain goes through
+   median / outlier rejection, on the readings as they come
+   resampling onto a fixed control rate grid
+   EMA or one-euro smoothing
+   slew limiting
+ The filters run after the resampling so their time constants mean the same
+ thing however irregularly a sensor reports. Each call works through the
+ readings of a batch channel by channel, one stage at a time over a block of
+ grid samples. Sensors without a chain are passed through as they are.
+
+ Readings are placed in time by the board's millis() when the wire format
+ carries it, by host arrival time otherwise. A gap of more than
+ maxGapMs restarts the grid rather than filling it in.
+
+ Runs on whichever thread feeds the SensorIngest; the chains and the control
+ rate may only be changed while nothing is coming in.
+ */
+class SensorConditioner
+{
+public:
+  static constexpr int maxMedianLength = 9;
+  static constexpr double maxGapMs = 1000.0;
+
+  explicit SensorConditioner(double controlRateHz = 100.0);
+
+  void setControlRate(double controlRateHz);
+  double getControlRate() const noexcept { return controlRateHz_; }
+
+  void setChain(int sensor, const ConditioningChain& chain);
+  void clearChain(int sensor);
+  bool hasChain(int sensor) const noexcept { return channels_[sensor].enabled; }
+
+  /**
+   Conditions a batch of readings that arrived at hostTimeMs. out needs room
+   for numRecords; it gets the unconditioned readings in order, then the
+   latest grid value of each conditioned sensor that had any. Returns how many
+   records were written.
+   */
+  int process(const SensorRecord* records, int numRecords, double hostTimeMs,
+              SensorRecord* out) noexcept;
+
+  /** Forget all history, e.g. after reopening the port */
+  void reset() noexcept;
+
+  /** Readings replaced by the median for being too far off it */
+  juce::uint64 getRejectedCount(int sensor) const noexcept { return channels_[sensor].rejected; }
+
+private:
+  static constexpr int blockSize = 64;
+
+  struct Channel
+  {
+    bool enabled = false;
+    ConditioningChain chain;
+
+    // median
+    float history[maxMedianLength];
+    int historyLength = 0;
+    int historyPos = 0;
+
+    // resampling
+    bool started = false;
+    double lastTime = 0.0;
+    float lastValue = 0.0f;
+    double nextTick = 0.0;
+
+    // filters, in grid samples
+    float emaAlpha = 1.0f;
+    float smoothed = 0.0f;
+    float lastInput = 0.0f;
+    float derivative = 0.0f;
+    float slewed = 0.0f;
+    float maxStep = 0.0f;
+
+    juce::uint64 rejected = 0;
+  };
+
+  void prepare(Channel& channel) noexcept;
+  void clear(Channel& channel) noexcept;
+
+  int gather(int sensor, const SensorRecord* records, int numRecords,
+             double hostTimeMs, float* values, double* times,
+             juce::uint32& deviceTime) const noexcept;
+  void rejectOutliers(Channel& channel, float* values, int numValues) noexcept;
+  /** Returns false if no grid sample came due */
+  bool resample(Channel& channel, const float* values, const double* times,
+                int numValues) noexcept;
+  void smooth(Channel& channel, float* grid, int numSamples) noexcept;
+  void limitSlew(Channel& channel, float* grid, int numSamples) noexcept;
+
+  double controlRateHz_;
+  double periodMs_;
+  Channel channels_[numSensorIds];
+
+  JUCE_DECLARE_NON_COPYABLE(SensorConditioner)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    SensorDecoder.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorDecoder.h"
+
+namespace BioSignals
+{
+
+SensorStreamDecoder::SensorStreamDecoder()
+{
+  sensorFrameDecoderReset(&frames_);
+  pendingFrame_.count = 0;
+}
+
+SensorLineParser::Result SensorStreamDecoder::decode(
+    const void* data, int numBytes, SensorRecord* out, int maxRecords) noexcept
+{
+  auto* bytes = static_cast<const juce::uint8*>(data);
+
+  if (format_ == ASCII_LINES)
+  {
+    auto* zero = autoDetect_ ? memchr(bytes, 0, (size_t) numBytes) : nullptr;
+    if (zero == nullptr)
+      return lines_.parse(bytes, numBytes, out, maxRecords);
+
+    // binary frames from here on; whatever came before the first delimiter
+    // is a partial frame and gets counted as such by the frame decoder
+    format_ = BINARY_FRAMES;
+    lines_.reset();
+  }
+
+  return decodeFrames(bytes, numBytes, out, maxRecords);
+}
+
+SensorLineParser::Result SensorStreamDecoder::decodeFrames(
+    const juce::uint8* data, int numBytes, SensorRecord* out, int maxRecords) noexcept
+{
+  int numRecords = 0;
+  int consumed = 0;
+
+  for (;;)
+  {
+    // hand out what's left of the last frame first
+    while (pendingRecord_ < pendingFrame_.count && numRecords < maxRecords)
+    {
+      const auto& rec = pendingFrame_.records[pendingRecord_++];
+      out[numRecords].sensor = rec.sensor;
+      out[numRecords].value = sensorFrameValueToFloat(rec.value);
+      out[numRecords].deviceTime = pendingFrame_.timestamp;
+      ++numRecords;
+    }
+
+    if (numRecords == maxRecords || consumed == numBytes)
+      break;
+
+    bool gotFrame = false;
+    consumed += sensorFrameDecode(&frames_, data + consumed, numBytes - consumed,
+                                  &pendingFrame_, &gotFrame);
+    pendingRecord_ = 0;
+    if (!gotFrame)
+      pendingFrame_.count = 0;
+  }
+
+  return { numRecords, consumed };
+}
+
+void SensorStreamDecoder::setWireFormat(WireFormat format) noexcept
+{
+  format_ = format;
+  autoDetect_ = false;
+  reset();
+}
+
+void SensorStreamDecoder::reset() noexcept
+{
+  lines_.reset();
+  frames_.length = 0;
+  frames_.overflowed = 0;
+  pendingFrame_.count = 0;
+  pendingRecord_ = 0;
+}
+
+} // namespace BioSignals
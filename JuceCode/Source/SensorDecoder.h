@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    SensorDecoder.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorParser.h"
+#include "sensor_frame.h"
+
+namespace BioSignals
+{
+
+/**
+ Turns the raw serial byte stream into SensorRecords, whichever wire format the
+ board is speaking.
+
+ Starts out assuming the ASCII line protocol. ASCII never contains a zero
+ byte, so the first 0x00 means the sketch was built with USE_BINARY_FRAMES and
+ from then on the stream is decoded as COBS framed binary (see sensor_frame.h).
+ */
+class SensorStreamDecoder
+{
+public:
+  enum WireFormat
+  {
+    ASCII_LINES,
+    BINARY_FRAMES
+  };
+
+  SensorStreamDecoder();
+
+  /**
+   Same contract as SensorLineParser::parse(). If out fills up part way
+   through a binary frame, the rest of that frame comes out of the next call
+   (which may pass numBytes == 0 to just collect them).
+   */
+  SensorLineParser::Result decode(const void* data, int numBytes,
+                                  SensorRecord* out, int maxRecords) noexcept;
+
+  /** Force a format instead of detecting it */
+  void setWireFormat(WireFormat format) noexcept;
+  WireFormat getWireFormat() const noexcept { return format_; }
+
+  void reset() noexcept;
+
+  const SensorLineParser& getLineParser() const noexcept { return lines_; }
+  const SensorFrameDecoder& getFrameDecoder() const noexcept { return frames_; }
+
+private:
+  SensorLineParser::Result decodeFrames(const juce::uint8* data, int numBytes,
+                                        SensorRecord* out, int maxRecords) noexcept;
+
+  WireFormat format_ = ASCII_LINES;
+  bool autoDetect_ = true;
+  SensorLineParser lines_;
+  SensorFrameDecoder frames_;
+  SensorFrame pendingFrame_;
+  int pendingRecord_ = 0; // records of pendingFrame_ already handed out
+};
+
+} // namespace BioSignals
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    SensorDispatch.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorDispatch.h"
+
+namespace BioSignals
+{
+
+SensorDispatcher::SensorDispatcher(SensorIngest& ingest, Handler handler) :
+    ingest_(ingest), handler_(std::move(handler))
+{
+  for (int sensor = 0; sensor < numSensorIds; ++sensor)
+    policies_[sensor] = LATEST_ONLY;
+  for (auto& device : lastArrival_)
+    for (auto& arrival : device)
+      arrival = -1.0;
+  policies_[ACCLX] = EVERY_RECORD;
+  policies_[ACCLY] = EVERY_RECORD;
+  policies_[ACCLZ] = EVERY_RECORD;
+}
+
+int SensorDispatcher::dispatch()
+{
+  const juce::uint64 notifications = ingest_.getNotificationCount();
+  ++stats_.wakeups;
+  if (notifications - lastNotificationCount_ > 1)
+    stats_.coalescedNotifications += notifications - lastNotificationCount_ - 1;
+  lastNotificationCount_ = notifications;
+
+  // whatever turns up while we're at it comes with a change message of its own
+  int remaining = ingest_.getNumQueuedEvents();
+  stats_.lastBacklog = remaining;
+  stats_.maxBacklog = juce::jmax(stats_.maxBacklog, remaining);
+
+  const double now = juce::Time::getMillisecondCounterHiRes();
+  SensorEvent batch[batchSize];
+  SensorEvent latest[numSlots];
+  bool haveLatest[numSlots] = {};
+  int calls = 0;
+
+  while (remaining > 0)
+  {
+    const int count = ingest_.readEvents(batch, juce::jmin(remaining, batchSize));
+    if (count == 0)
+      break;
+    remaining -= count;
+    if (tap_ != nullptr)
+      tap_(batch, count);
+
+    for (int idx = 0; idx < count; ++idx)
+    {
+      const int sensor = batch[idx].record.sensor;
+      if (sensor >= numSensorIds)
+        continue; // not one of ours
+      const int slot = batch[idx].device * numSensorIds + sensor;
+
+      if (policies_[sensor] == EVERY_RECORD)
+      {
+        deliver(batch[idx], now);
+        ++calls;
+      }
+      else
+      {
+        stats_.coalescedRecords += haveLatest[slot] ? 1 : 0;
+        latest[slot] = batch[idx];
+        haveLatest[slot] = true;
+      }
+    }
+  }
+
+  // coalesced readings go out after the batch they were picked from
+  for (int slot = 0; slot < numSlots; ++slot)
+  {
+    if (haveLatest[slot])
+    {
+      deliver(latest[slot], now);
+      ++calls;
+    }
+  }
+
+  return calls;
+}
+
+void SensorDispatcher::deliver(const SensorEvent& event, double now)
+{
+  const int sensor = event.record.sensor;
+  const int device = event.device;
+  staleness_[device][sensor] = now - event.hostTimeMs;
+  maxStaleness_[device][sensor] = juce::jmax(maxStaleness_[device][sensor],
+                                             staleness_[device][sensor]);
+  lastArrival_[device][sensor] = event.hostTimeMs;
+  ++stats_.delivered;
+  handler_(event);
+}
+
+double SensorDispatcher::getAgeMs(int sensor, int device) const noexcept
+{
+  if (lastArrival_[device][sensor] < 0.0)
+    return -1.0;
+  return juce::Time::getMillisecondCounterHiRes() - lastArrival_[device][sensor];
+}
+
+void SensorDispatcher::resetStats()
+{
+  stats_ = Stats();
+  lastNotificationCount_ = ingest_.getNotificationCount();
+  for (int device = 0; device < maxSensorDevices; ++device)
+  {
+    for (int sensor = 0; sensor < numSensorIds; ++sensor)
+    {
+      staleness_[device][sensor] = 0.0;
+      maxStaleness_[device][sensor] = 0.0;
+    }
+  }
+}
+
+} // namespace BioSignals
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    SensorDispatch.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorIngest.h"
+
+namespace BioSignals
+{
+
+/**
+ Hands the readings queued by a SensorIngest to a handler on the message thread.
+
+ Change messages coalesce, so one wakeup may stand for any number of readings.
+ dispatch() always empties the whole queue, whatever arrived since the last
+ wakeup, so nothing is left behind to go stale.
+
+ Sensors whose readings are just "the current level" (temperatures, the pulse
+ rate) are coalesced: only the newest one per device per wakeup is passed on. Sensors
+ where every sample counts, like the accelerometer axes, are passed on one by
+ one, in order.
+ */
+class SensorDispatcher
+{
+public:
+  enum Policy
+  {
+    LATEST_ONLY,
+    EVERY_RECORD
+  };
+
+  struct Stats
+  {
+    juce::uint64 wakeups = 0;
+    juce::uint64 coalescedNotifications = 0; // change messages that didn't get their own wakeup
+    juce::uint64 delivered = 0;
+    juce::uint64 coalescedRecords = 0;       // LATEST_ONLY readings superseded before delivery
+    int lastBacklog = 0;                     // readings waiting at the last wakeup
+    int maxBacklog = 0;
+  };
+
+  using Handler = std::function<void (const SensorEvent&)>;
+  using Tap = std::function<void (const SensorEvent* events, int numEvents)>;
+
+  SensorDispatcher(SensorIngest& ingest, Handler handler);
+
+  void setPolicy(int sensor, Policy policy) { policies_[sensor] = policy; }
+  Policy getPolicy(int sensor) const { return policies_[sensor]; }
+
+  /** Sees every reading in arrival order before anything is coalesced, e.g. to record it */
+  void setTap(Tap tap) { tap_ = std::move(tap); }
+
+  /** Drain everything queued and pass it on. Returns the number of handler calls */
+  int dispatch();
+
+  const Stats& getStats() const noexcept { return stats_; }
+
+  /** How long the newest delivered reading of sensor had been waiting, in ms */
+  double getStalenessMs(int sensor, int device = 0) const noexcept
+  {
+    return staleness_[device][sensor];
+  }
+  double getMaxStalenessMs(int sensor, int device = 0) const noexcept
+  {
+    return maxStaleness_[device][sensor];
+  }
+
+  /** Time since sensor last delivered anything, or -1 if it never has */
+  double getAgeMs(int sensor, int device = 0) const noexcept;
+
+  void resetStats();
+
+private:
+  static constexpr int batchSize = 256;
+  static constexpr int numSlots = maxSensorDevices * numSensorIds;
+
+  void deliver(const SensorEvent& event, double now);
+
+  SensorIngest& ingest_;
+  Handler handler_;
+  Tap tap_;
+  Policy policies_[numSensorIds];
+
+  Stats stats_;
+  juce::uint64 lastNotificationCount_ = 0;
+  double staleness_[maxSensorDevices][numSensorIds] = {};
+  double maxStaleness_[maxSensorDevices][numSensorIds] = {};
+  double lastArrival_[maxSensorDevices][numSensorIds];
+
+  JUCE_DECLARE_NON_COPYABLE(SensorDispatcher)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,194 @@
+/*
+  ==============================================================================
+
+    SensorFeatures.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorFeatures.h"
+
+namespace BioSignals
+{
+
+/** Frames nobody reported a timestamp for are assumed to be this far apart */
+static constexpr double nominalFrameRateHz = 100.0;
+
+static float sum(const float* data, int num) noexcept
+{
+  float total = 0.0f;
+  for (int idx = 0; idx < num; ++idx)
+    total += data[idx];
+  return total;
+}
+
+void MotionFeatureExtractor::reset() noexcept
+{
+  features_ = MotionFeatures();
+  have_ = 0;
+  pos_ = windowSize - 1;
+  frames_ = 0;
+  sinceHop_ = 0;
+  slowJerk_ = 0.0f;
+  lastOnsetMs_ = 0.0;
+  shaking_ = false;
+  for (int axis = 0; axis < 3; ++axis)
+    axis_[axis] = 0.0f;
+}
+
+bool MotionFeatureExtractor::process(const SensorRecord* records, int numRecords,
+                                     double hostTimeMs) noexcept
+{
+  bool updated = false;
+  for (int idx = 0; idx < numRecords; ++idx)
+  {
+    const int axis = records[idx].sensor - ACCLX;
+    if (axis < 0 || axis > 2)
+      continue;
+
+    const double time = records[idx].deviceTime != 0 ? (double) records[idx].deviceTime
+                                                     : hostTimeMs;
+    // an axis coming round again means we missed one: go with the last of it
+    if ((have_ & (1 << axis)) != 0)
+      pushFrame(time);
+    axis_[axis] = records[idx].value;
+    have_ |= 1 << axis;
+    if (have_ == 7)
+      pushFrame(time);
+
+    if (sinceHop_ >= hopSize && frames_ >= (juce::uint64) windowSize)
+    {
+      computeFeatures();
+      sinceHop_ = 0;
+      updated = true;
+    }
+  }
+  return updated;
+}
+
+void MotionFeatureExtractor::pushFrame(double time) noexcept
+{
+  pos_ = (pos_ + 1) % windowSize;
+  x_[pos_] = x_[pos_ + windowSize] = axis_[0];
+  y_[pos_] = y_[pos_ + windowSize] = axis_[1];
+  z_[pos_] = z_[pos_ + windowSize] = axis_[2];
+  time_[pos_] = time_[pos_ + windowSize] = time;
+  have_ = 0;
+  ++frames_;
+  ++sinceHop_;
+}
+
+void MotionFeatureExtractor::computeFeatures() noexcept
+{
+  using FVO = juce::FloatVectorOperations;
+  constexpr int n = windowSize;
+  const int start = (pos_ + 1) % windowSize;
+  const float* x = x_ + start;
+  const float* y = y_ + start;
+  const float* z = z_ + start;
+  const double* t = time_ + start;
+  float scratch[n];
+  float magnitude[n];
+
+  // frames that came in one read share a host time; fall back on the
+  // nominal rate when the timestamps can't tell us any better
+  const double spanMs = t[n - 1] - t[0];
+  const double rate = spanMs > 0.0 && spanMs < 10.0 * 1000.0 * n / nominalFrameRateHz
+                          ? 1000.0 * (n - 1) / spanMs
+                          : nominalFrameRateHz;
+
+  // tilt, from the mean acceleration, which is mostly gravity
+  const float meanX = sum(x, n) / n;
+  const float meanY = sum(y, n) / n;
+  const float meanZ = sum(z, n) / n;
+  features_.value[PITCH] = juce::radiansToDegrees(
+      std::atan2(-meanX, std::sqrt(meanY * meanY + meanZ * meanZ)));
+  features_.value[ROLL] = juce::radiansToDegrees(std::atan2(meanY, meanZ));
+
+  // what's left once the mean, i.e. gravity, is taken out of each axis. its
+  // RMS magnitude is the sum of the axes' variances
+  const float* axes[3] = { x, y, z };
+  const float means[3] = { meanX, meanY, meanZ };
+  float variances[3];
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    FVO::copy(scratch, axes[axis], n);
+    FVO::add(scratch, -means[axis], n);
+    FVO::multiply(scratch, scratch, n);
+    variances[axis] = sum(scratch, n) / n;
+  }
+  const float motionRms = std::sqrt(variances[0] + variances[1] + variances[2]);
+  features_.value[MOTION_RMS] = motionRms;
+
+  // jerk, frame to frame. the last hop's share of it is what onsets look at
+  float jerk[n - 1];
+  FVO::subtract(jerk, x + 1, x, n - 1);
+  FVO::multiply(jerk, jerk, n - 1);
+  FVO::subtract(scratch, y + 1, y, n - 1);
+  FVO::addWithMultiply(jerk, scratch, scratch, n - 1);
+  FVO::subtract(scratch, z + 1, z, n - 1);
+  FVO::addWithMultiply(jerk, scratch, scratch, n - 1);
+  for (int idx = 0; idx < n - 1; ++idx)
+    jerk[idx] = std::sqrt(jerk[idx]) * (float) rate;
+  features_.value[JERK] = sum(jerk, n - 1) / (n - 1);
+
+  const float hopJerk = sum(jerk + n - 1 - hopSize, hopSize) / hopSize;
+  const double now = t[n - 1];
+  if (hopJerk > settings_.onsetRatio * slowJerk_ + settings_.onsetFloor
+      && (features_.onsets == 0 || now - lastOnsetMs_ >= settings_.onsetHoldMs))
+  {
+    ++features_.onsets;
+    lastOnsetMs_ = now;
+  }
+  // about a second's memory, at one update per hop
+  slowJerk_ += (hopJerk - slowJerk_) * (float) juce::jmin(1.0, hopSize / rate);
+  features_.value[ONSETS] = (float) features_.onsets;
+
+  if (motionRms > settings_.shakeRms)
+    shaking_ = true;
+  else if (motionRms < 0.7f * settings_.shakeRms)
+    shaking_ = false;
+  features_.value[SHAKE] = shaking_ ? 1.0f : 0.0f;
+
+  // dominant movement along whichever axis is moving the most
+  int busiest = 0;
+  for (int axis = 1; axis < 3; ++axis)
+    if (variances[axis] > variances[busiest])
+      busiest = axis;
+  features_.value[MOVEMENT_HZ] = dominantFrequency(axes[busiest], means[busiest],
+                                                   variances[busiest], rate);
+}
+
+float MotionFeatureExtractor::dominantFrequency(const float* axis, float mean, float variance,
+                                                double rate) const noexcept
+{
+  const float deviation = std::sqrt(variance);
+  if (deviation < settings_.minMovement)
+    return 0.0f;
+
+  // zero crossings, with some hysteresis so noise around the mean doesn't
+  // count. timing from the first to the last rather than counting them over
+  // the window keeps a short window from rounding to whole crossings
+  const float hysteresis = 0.25f * deviation;
+  int side = 0;
+  int crossings = 0;
+  int first = 0;
+  int last = 0;
+  for (int idx = 0; idx < windowSize; ++idx)
+  {
+    const float value = axis[idx] - mean;
+    const int now = value > hysteresis ? 1 : (value < -hysteresis ? -1 : side);
+    if (side != 0 && now != side)
+    {
+      if (crossings++ == 0)
+        first = idx;
+      last = idx;
+    }
+    side = now;
+  }
+  if (crossings < 2)
+    return 0.0f;
+  return (float) ((crossings - 1) * rate / (2.0 * (last - first)));
+}
+
+} // namespace BioSignals
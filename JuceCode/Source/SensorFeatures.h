@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    SensorFeatures.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorParser.h"
+
+namespace BioSignals
+{
+
+/** What MotionFeatureExtractor makes of the accelerometer, in m/s^2 unless noted */
+enum MotionFeature
+{
+  MOTION_RMS,   // RMS magnitude of the acceleration over the window, gravity removed
+  JERK,         // mean magnitude of the change in acceleration, m/s^3
+  PITCH,        // tilt of the board from the window's mean acceleration, degrees
+  ROLL,         // degrees
+  SHAKE,        // 1 while MOTION_RMS is above Settings::shakeRms, else 0
+  ONSETS,       // number of sudden movements so far
+  MOVEMENT_HZ,  // rate of the dominant back and forth movement
+  numMotionFeatures
+};
+
+struct MotionFeatures
+{
+  float value[numMotionFeatures] = {};
+  juce::uint32 onsets = 0;
+};
+
+/**
+ Turns the ACCLX/ACCLY/ACCLZ streams of one board into MotionFeatures.
+
+ Axis readings are put together into frames as they arrive (one of each per
+ loop of arduino_analog.ino) and kept in a window of the last windowSize
+ frames, one contiguous array per axis so each feature is a few passes of
+ FloatVectorOperations over it. Features are worked out every hopSize
+ frames: at the LIS3DH's 100 Hz that's a 0.64 s window, updated 12.5 times a
+ second, for a few microseconds each.
+
+ Runs on whichever thread feeds the SensorIngest. Not thread safe.
+ */
+class MotionFeatureExtractor
+{
+public:
+  static constexpr int windowSize = 64;
+  static constexpr int hopSize = 8;
+
+  struct Settings
+  {
+    float onsetRatio = 2.5f;     // onset when a hop's jerk is this many times the recent average
+    float onsetFloor = 30.0f;    // ... plus this, so a board at rest doesn't trigger on noise
+    double onsetHoldMs = 150.0;  // least time between onsets
+    float shakeRms = 4.0f;       // SHAKE turns on above this, off below 0.7 of it
+    float minMovement = 0.3f;    // MOVEMENT_HZ is 0 for axes moving less than this (std dev)
+  };
+
+  MotionFeatureExtractor() { reset(); }
+
+  /** Only while nothing is coming in */
+  void setSettings(const Settings& settings) noexcept { settings_ = settings; }
+  const Settings& getSettings() const noexcept { return settings_; }
+
+  /**
+   Takes the accelerometer readings out of a batch that arrived at
+   hostTimeMs and ignores the rest. Returns true if getFeatures() has been
+   worked out again.
+   */
+  bool process(const SensorRecord* records, int numRecords, double hostTimeMs) noexcept;
+
+  const MotionFeatures& getFeatures() const noexcept { return features_; }
+  juce::uint64 getNumFrames() const noexcept { return frames_; }
+
+  void reset() noexcept;
+
+private:
+  void pushFrame(double time) noexcept;
+  void computeFeatures() noexcept;
+  float dominantFrequency(const float* axis, float mean, float variance,
+                          double rate) const noexcept;
+
+  Settings settings_;
+  MotionFeatures features_;
+
+  // the frame being put together
+  float axis_[3];
+  int have_ = 0; // bit per axis
+
+  // every frame goes in twice, windowSize apart, so the last windowSize of
+  // them are always contiguous from pos_ + 1
+  float x_[2 * windowSize];
+  float y_[2 * windowSize];
+  float z_[2 * windowSize];
+  double time_[2 * windowSize];
+  int pos_ = 0;
+  juce::uint64 frames_ = 0;
+  int sinceHop_ = 0;
+
+  float slowJerk_ = 0.0f;
+  double lastOnsetMs_ = 0.0;
+  bool shaking_ = false;
+
+  JUCE_DECLARE_NON_COPYABLE(MotionFeatureExtractor)
+};
+
+/** Maps a feature, or any control, onto the range of a synth parameter */
+struct FeatureMapping
+{
+  float inMin;
+  float inMax;
+  float outMin;
+  float outMax;
+  float curve = 1.0f; // exponent applied to the normalised input
+
+  float map(float value) const noexcept
+  {
+    const float proportion = juce::jlimit(0.0f, 1.0f, (value - inMin) / (inMax - inMin));
+    return outMin + std::pow(proportion, curve) * (outMax - outMin);
+  }
+};
+
+} // namespace BioSignals
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    SensorIngest.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorIngest.h"
+
+namespace BioSignals
+{
+
+void SensorIngest::handleBytes(int device, const void* data, int numBytes,
+                               double hostTimeMs) noexcept
+{
+  jassert(device >= 0 && device < maxSensorDevices);
+  auto& decoder = decoders_[device];
+  auto* bytes = static_cast<const char*>(data);
+  SensorRecord records[recordBatchSize];
+  bool published = false;
+
+  int offset = 0;
+  for (;;)
+  {
+    auto result = decoder.decode(bytes + offset, numBytes - offset,
+                                 records, recordBatchSize);
+    publish(device, records, result.numRecords, hostTimeMs);
+    published = published || result.numRecords > 0;
+    offset += result.bytesConsumed;
+
+    // a full batch may have left records of a frame behind, even with
+    // every byte consumed
+    if (result.numRecords < recordBatchSize && offset >= numBytes)
+      break;
+  }
+
+  if (published)
+    notify();
+}
+
+void SensorIngest::handleRecords(int device, const SensorRecord* records,
+                                 int numRecords, double hostTimeMs) noexcept
+{
+  jassert(device >= 0 && device < maxSensorDevices);
+  if (numRecords == 0)
+    return;
+
+  for (int offset = 0; offset < numRecords; offset += recordBatchSize)
+    publish(device, records + offset, juce::jmin(recordBatchSize, numRecords - offset),
+            hostTimeMs);
+  notify();
+}
+
+void SensorIngest::notify() noexcept
+{
+  notifications_.fetch_add(1, std::memory_order_relaxed);
+  sendChangeMessage();
+}
+
+void SensorIngest::publish(int device, const SensorRecord* records, int numRecords,
+                           double hostTimeMs) noexcept
+{
+  jassert(numRecords <= recordBatchSize);
+  if (numRecords == 0)
+    return;
+
+  SensorRecord conditioned[recordBatchSize];
+  const int numConditioned = conditioners_[device].process(records, numRecords,
+                                                           hostTimeMs, conditioned);
+  for (int idx = 0; idx < numConditioned; ++idx)
+    values_[device].publish(conditioned[idx]);
+
+  auto& extractor = extractors_[device];
+  if (extractor.process(records, numRecords, hostTimeMs))
+  {
+    const auto& features = extractor.getFeatures();
+    for (int feature = 0; feature < numMotionFeatures; ++feature)
+      if (feature != ONSETS)
+        motion_[device].publish(feature, features.value[feature]);
+    // only when there's a new one, so readIfNewer() on it means "onset"
+    if (features.onsets != lastOnsets_[device])
+    {
+      lastOnsets_[device] = features.onsets;
+      motion_[device].publish(ONSETS, (float) features.onsets);
+    }
+  }
+
+  int start1, size1, start2, size2;
+  eventFifo_.prepareToWrite(numRecords, start1, size1, start2, size2);
+  for (int idx = 0; idx < size1; ++idx)
+    events_[start1 + idx] = { records[idx], (juce::uint8) device, hostTimeMs };
+  for (int idx = 0; idx < size2; ++idx)
+    events_[start2 + idx] = { records[size1 + idx], (juce::uint8) device, hostTimeMs };
+  eventFifo_.finishedWrite(size1 + size2);
+
+  if (size1 + size2 < numRecords)
+    droppedEvents_.fetch_add((juce::uint64) (numRecords - size1 - size2),
+                             std::memory_order_relaxed);
+}
+
+int SensorIngest::readEvents(SensorEvent* dest, int maxEvents) noexcept
+{
+  int start1, size1, start2, size2;
+  eventFifo_.prepareToRead(maxEvents, start1, size1, start2, size2);
+  std::copy(events_ + start1, events_ + start1 + size1, dest);
+  std::copy(events_ + start2, events_ + start2 + size2, dest + size1);
+  eventFifo_.finishedRead(size1 + size2);
+  return size1 + size2;
+}
+
+} // namespace BioSignals
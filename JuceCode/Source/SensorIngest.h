@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    SensorIngest.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "AtomicValueBlock.h"
+#include "SensorDecoder.h"
+#include "SensorConditioner.h"
+#include "SensorFeatures.h"
+
+namespace BioSignals
+{
+
+/** The latest reading of every sensor id */
+class SensorValueBlock : public AtomicValueBlock<numSensorIds>
+{
+public:
+  using AtomicValueBlock::publish;
+
+  /** Records for ids we don't know about are ignored */
+  void publish(const SensorRecord& record) noexcept
+  {
+    if (record.sensor < numSensorIds)
+      publish(record.sensor, record.value);
+  }
+};
+
+/** The latest of each MotionFeature */
+using MotionValueBlock = AtomicValueBlock<numMotionFeatures>;
+
+/**
+ Decodes serial bytes on the serial reader thread and publishes the readings
+ to a SensorValueBlock for the audio thread.
+
+ Every reading is also queued, in order, for whoever wants each one rather
+ than just the latest (see SensorDispatcher). When nobody drains that queue
+ it fills up and further events are dropped and counted; the value block is
+ updated regardless.
+
+ Hook it up through the SerialPortInputStream constructor that takes a
+ SerialDataFunction, e.g.
+
+   new SerialPortInputStream(port, [this] (auto* data, int size)
+                                   { ingest.handleBytes(data, size); });
+
+ or, for several boards, to a SerialPortMultiplexer, passing its port index
+ as the device. Each device gets its own decoder and value block; their
+ events share the one queue. That queue has a single producer, so all the
+ bytes have to come from one thread: the multiplexer's, or the one
+ SerialPortInputStream's. Events then come out in the order they arrived,
+ which is one time-ordered stream across all devices.
+
+ Readings are conditioned (see SensorConditioner) on the same thread before
+ they reach the value block, and the accelerometer axes are turned into
+ MotionFeatures there too. The event queue keeps them as they came off the
+ wire, so a recording holds what the sensors actually said.
+
+ Nothing on the way from the port to the audio callback goes through the
+ message thread. The GUI is only told (via the ChangeBroadcaster side) that
+ something new arrived, so it can redraw from getValues() when it gets round
+ to it; a stalled GUI delays the display, never the sound.
+ */
+class SensorIngest : public juce::ChangeBroadcaster
+{
+public:
+  SensorIngest() = default;
+
+  /** Reader thread only */
+  void handleBytes(int device, const void* data, int numBytes) noexcept
+  {
+    handleBytes(device, data, numBytes, juce::Time::getMillisecondCounterHiRes());
+  }
+  void handleBytes(const void* data, int numBytes) noexcept { handleBytes(0, data, numBytes); }
+
+  /** Same as handleBytes() for readings that are already decoded, e.g. a replayed log */
+  void handleRecords(int device, const SensorRecord* records, int numRecords) noexcept
+  {
+    handleRecords(device, records, numRecords, juce::Time::getMillisecondCounterHiRes());
+  }
+
+  /**
+   The same again, stamped with the caller's own clock rather than the host's,
+   e.g. the virtual one of an offline render. Keep it one clock per ingest,
+   the conditioners and the motion features time everything off it
+   */
+  void handleBytes(int device, const void* data, int numBytes, double hostTimeMs) noexcept;
+  void handleRecords(int device, const SensorRecord* records, int numRecords,
+                     double hostTimeMs) noexcept;
+
+  const SensorValueBlock& getValues(int device = 0) const noexcept { return values_[device]; }
+  const MotionValueBlock& getMotion(int device = 0) const noexcept { return motion_[device]; }
+
+  /** Single consumer side of the event queue. Returns how many were copied */
+  int readEvents(SensorEvent* dest, int maxEvents) noexcept;
+  int getNumQueuedEvents() const noexcept { return eventFifo_.getNumReady(); }
+  juce::uint64 getDroppedEventCount() const noexcept { return droppedEvents_.load(); }
+
+  /** How many change messages handleBytes() has asked for, coalesced or not */
+  juce::uint64 getNotificationCount() const noexcept { return notifications_.load(); }
+
+  /** Only while no bytes are coming in, e.g. before the port is opened */
+  SensorStreamDecoder& getDecoder(int device = 0) noexcept { return decoders_[device]; }
+  SensorConditioner& getConditioner(int device = 0) noexcept { return conditioners_[device]; }
+  MotionFeatureExtractor& getMotionExtractor(int device = 0) noexcept { return extractors_[device]; }
+
+private:
+  static constexpr int recordBatchSize = 64;
+  static constexpr int eventQueueSize = 4096;
+
+  void publish(int device, const SensorRecord* records, int numRecords,
+               double hostTimeMs) noexcept;
+  void notify() noexcept;
+
+  SensorStreamDecoder decoders_[maxSensorDevices];
+  SensorConditioner conditioners_[maxSensorDevices];
+  SensorValueBlock values_[maxSensorDevices];
+  MotionFeatureExtractor extractors_[maxSensorDevices];
+  MotionValueBlock motion_[maxSensorDevices];
+  juce::uint32 lastOnsets_[maxSensorDevices] = {};
+
+  juce::AbstractFifo eventFifo_ { eventQueueSize };
+  juce::HeapBlock<SensorEvent> events_ { (size_t) eventQueueSize };
+  std::atomic<juce::uint64> droppedEvents_ { 0 };
+  std::atomic<juce::uint64> notifications_ { 0 };
+
+  JUCE_DECLARE_NON_COPYABLE(SensorIngest)
+};
+
+} // namespace BioSignals
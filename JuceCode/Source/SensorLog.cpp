@@ -0,0 +1,513 @@
+/*
+  ==============================================================================
+
+    SensorLog.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorLog.h"
+
+namespace BioSignals
+{
+
+namespace
+{
+
+const char fileMagic[4] = { 'B', 'S', 'L', 'G' };
+const char chunkMagic[4] = { 'C', 'H', 'N', 'K' };
+const char indexMagic[4] = { 'I', 'N', 'D', 'X' };
+const char trailerMagic[4] = { 'B', 'S', 'L', 'E' };
+
+constexpr juce::uint16 logVersion = 1;
+constexpr int fileHeaderSize = 16;
+constexpr int chunkHeaderSize = 20;
+constexpr int indexEntrySize = 28;
+constexpr int trailerSize = 12;
+
+constexpr double fixedScale = 100.0;
+constexpr double fixedLimit = 1.0e7; // keeps value x 100 and its deltas in an int32
+
+/** The fixed point form of value, if it survives the round trip exactly */
+inline bool toFixed(float value, juce::int32& fixed)
+{
+  const double scaled = std::round((double) value * fixedScale);
+  if (!(std::abs(scaled) < fixedLimit) || (float) (scaled / fixedScale) != value)
+    return false;
+  fixed = (juce::int32) scaled;
+  return true;
+}
+
+void writeVarint(juce::OutputStream& out, juce::uint64 value)
+{
+  while (value >= 0x80)
+  {
+    out.writeByte((char) (value | 0x80));
+    value >>= 7;
+  }
+  out.writeByte((char) value);
+}
+
+bool readVarint(const juce::uint8*& p, const juce::uint8* end, juce::uint64& value)
+{
+  value = 0;
+  for (int shift = 0; shift < 64 && p < end; shift += 7)
+  {
+    const juce::uint8 byte = *p++;
+    value |= (juce::uint64) (byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+inline juce::uint64 zigzag(juce::int32 value)
+{
+  return (juce::uint32) ((juce::uint32) value << 1) ^ (juce::uint32) (value >> 31);
+}
+
+inline juce::int32 unzigzag(juce::uint64 value)
+{
+  return (juce::int32) (((juce::uint32) value >> 1) ^ (0u - ((juce::uint32) value & 1u)));
+}
+
+inline juce::uint32 floatBits(float value)
+{
+  juce::uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float floatFromBits(juce::uint32 bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline juce::int64 readInt64(const juce::uint8* p)
+{
+  return (juce::int64) juce::ByteOrder::littleEndianInt64(p);
+}
+
+inline juce::uint32 readUint32(const juce::uint8* p)
+{
+  return juce::ByteOrder::littleEndianInt(p);
+}
+
+} // namespace
+
+//==============================================================================
+bool SensorLogWriter::open(const juce::File& file, double sessionStartMs)
+{
+  close();
+
+  file.deleteFile(); // FileOutputStream appends otherwise
+  std::unique_ptr<juce::FileOutputStream> stream(new juce::FileOutputStream(file));
+  if (stream->failedToOpen())
+    return false;
+
+  const double sinceStart = juce::Time::getMillisecondCounterHiRes() - sessionStartMs;
+  stream->write(fileMagic, sizeof(fileMagic));
+  stream->writeShort((short) logVersion);
+  stream->writeShort((short) fileHeaderSize);
+  stream->writeInt64(juce::Time::currentTimeMillis() - (juce::int64) sinceStart);
+
+  stream_ = std::move(stream);
+  sessionStartMs_ = sessionStartMs;
+  chunk_.reset();
+  chunkEvents_ = 0;
+  lastTime_ = 0;
+  index_.clear();
+  eventsWritten_ = 0;
+  return true;
+}
+
+void SensorLogWriter::resetDeltas()
+{
+  memset(lastDeviceTime_, 0, sizeof(lastDeviceTime_));
+  memset(lastFixed_, 0, sizeof(lastFixed_));
+  memset(lastBits_, 0, sizeof(lastBits_));
+}
+
+void SensorLogWriter::write(const SensorEvent& event)
+{
+  if (stream_ == nullptr)
+    return;
+
+  const juce::int64 time = juce::jmax(
+      lastTime_, (juce::int64) ((event.hostTimeMs - sessionStartMs_) * 1000.0));
+
+  if (chunkEvents_ >= maxChunkEvents
+      || (chunkEvents_ > 0 && time - chunkFirstTime_ >= maxChunkMicros))
+    flush();
+
+  if (chunkEvents_ == 0)
+  {
+    chunkFirstTime_ = time;
+    lastTime_ = time;
+    resetDeltas();
+  }
+
+  const int device = event.device & 0x0f;
+  const int sensor = event.record.sensor;
+
+  writeVarint(chunk_, (juce::uint64) (time - lastTime_));
+  chunk_.writeByte((char) (device << 4 | juce::jmin(sensor, 15)));
+  if (sensor >= 15)
+    chunk_.writeByte((char) sensor);
+  writeVarint(chunk_, zigzag((juce::int32) (event.record.deviceTime - lastDeviceTime_[device])));
+
+  juce::int32 fixed;
+  if (toFixed(event.record.value, fixed))
+  {
+    writeVarint(chunk_, zigzag(fixed - lastFixed_[device][sensor]) << 1);
+    lastFixed_[device][sensor] = fixed;
+  }
+  else
+  {
+    const juce::uint32 bits = floatBits(event.record.value);
+    writeVarint(chunk_, (juce::uint64) (bits ^ lastBits_[device][sensor]) << 1 | 1);
+    lastBits_[device][sensor] = bits;
+  }
+
+  lastTime_ = time;
+  lastDeviceTime_[device] = event.record.deviceTime;
+  ++chunkEvents_;
+  ++eventsWritten_;
+}
+
+void SensorLogWriter::flush()
+{
+  if (stream_ == nullptr || chunkEvents_ == 0)
+    return;
+
+  index_.push_back({ stream_->getPosition(), chunkFirstTime_, lastTime_,
+                     (juce::uint32) chunkEvents_ });
+
+  stream_->write(chunkMagic, sizeof(chunkMagic));
+  stream_->writeInt((int) chunk_.getDataSize());
+  stream_->writeInt(chunkEvents_);
+  stream_->writeInt64(chunkFirstTime_);
+  stream_->write(chunk_.getData(), chunk_.getDataSize());
+  stream_->flush();
+
+  chunk_.reset();
+  chunkEvents_ = 0;
+}
+
+void SensorLogWriter::close()
+{
+  if (stream_ == nullptr)
+    return;
+
+  flush();
+
+  const juce::int64 indexOffset = stream_->getPosition();
+  stream_->write(indexMagic, sizeof(indexMagic));
+  stream_->writeInt((int) index_.size());
+  for (const auto& entry : index_)
+  {
+    stream_->writeInt64(entry.offset);
+    stream_->writeInt64(entry.firstTime);
+    stream_->writeInt64(entry.lastTime);
+    stream_->writeInt((int) entry.numEvents);
+  }
+  stream_->writeInt64(indexOffset);
+  stream_->write(trailerMagic, sizeof(trailerMagic));
+  stream_->flush();
+  stream_.reset();
+}
+
+//==============================================================================
+bool SensorLogReader::open(const juce::File& file)
+{
+  map_.reset();
+  index_.clear();
+  recovered_ = false;
+
+  std::unique_ptr<juce::MemoryMappedFile> map(
+      new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+  auto* data = static_cast<const juce::uint8*>(map->getData());
+  const size_t size = map->getSize();
+  if (data == nullptr || size < (size_t) fileHeaderSize
+      || memcmp(data, fileMagic, sizeof(fileMagic)) != 0
+      || juce::ByteOrder::littleEndianShort(data + 4) != logVersion)
+    return false;
+
+  map_ = std::move(map);
+  data_ = data;
+  size_ = size;
+  wallClockStartMs_ = readInt64(data + 8);
+
+  if (!readIndex())
+  {
+    recovered_ = true;
+    rebuildIndex();
+  }
+
+  chunk_ = -1;
+  eventsLeft_ = 0;
+  havePending_ = false;
+  return true;
+}
+
+bool SensorLogReader::readIndex()
+{
+  const size_t headerSize = juce::ByteOrder::littleEndianShort(data_ + 6);
+  if (headerSize < (size_t) fileHeaderSize || size_ < headerSize + 8 + trailerSize
+      || memcmp(data_ + size_ - 4, trailerMagic, sizeof(trailerMagic)) != 0)
+    return false;
+
+  const juce::int64 indexOffset = readInt64(data_ + size_ - trailerSize);
+  if (indexOffset < (juce::int64) headerSize
+      || (size_t) indexOffset + 8 > size_ - trailerSize
+      || memcmp(data_ + indexOffset, indexMagic, sizeof(indexMagic)) != 0)
+    return false;
+
+  const juce::uint32 numChunks = readUint32(data_ + indexOffset + 4);
+  if ((size_t) indexOffset + 8 + (size_t) numChunks * indexEntrySize > size_ - trailerSize)
+    return false;
+
+  auto* entry = data_ + indexOffset + 8;
+  for (juce::uint32 idx = 0; idx < numChunks; ++idx, entry += indexEntrySize)
+  {
+    // every chunk has to be a whole one, between the header and the index,
+    // as rebuildIndex() would have found it
+    const juce::int64 offset = readInt64(entry);
+    if (offset < (juce::int64) headerSize
+        || offset + chunkHeaderSize > indexOffset
+        || memcmp(data_ + offset, chunkMagic, sizeof(chunkMagic)) != 0
+        || offset + chunkHeaderSize + (juce::int64) readUint32(data_ + offset + 4) > indexOffset)
+    {
+      index_.clear();
+      return false;
+    }
+    index_.push_back({ offset, readInt64(entry + 8), readInt64(entry + 16),
+                       readUint32(entry + 24) });
+  }
+  return true;
+}
+
+bool SensorLogReader::rebuildIndex()
+{
+  // walk the chunks from the top, stopping at the first one that isn't all there
+  size_t offset = juce::ByteOrder::littleEndianShort(data_ + 6);
+  while (offset + chunkHeaderSize <= size_
+         && memcmp(data_ + offset, chunkMagic, sizeof(chunkMagic)) == 0)
+  {
+    const size_t payload = readUint32(data_ + offset + 4);
+    if (offset + chunkHeaderSize + payload > size_)
+      break;
+    const juce::int64 firstTime = readInt64(data_ + offset + 12);
+    index_.push_back({ (juce::int64) offset, firstTime, firstTime,
+                       readUint32(data_ + offset + 8) });
+    offset += chunkHeaderSize + payload;
+  }
+
+  // only the duration needs the last event time, so only the last chunk is decoded
+  if (!index_.empty())
+  {
+    chunk_ = (int) index_.size() - 2;
+    eventsLeft_ = 0;
+    SensorEvent event;
+    while (decodeEvent(event))
+      index_.back().lastTime = time_;
+  }
+  return !index_.empty();
+}
+
+double SensorLogReader::getDurationMs() const noexcept
+{
+  return index_.empty() ? 0.0 : (double) index_.back().lastTime / 1000.0;
+}
+
+juce::uint64 SensorLogReader::getNumEvents() const noexcept
+{
+  juce::uint64 total = 0;
+  for (const auto& entry : index_)
+    total += entry.numEvents;
+  return total;
+}
+
+bool SensorLogReader::seek(double timeMs)
+{
+  if (map_ == nullptr)
+    return false;
+
+  const juce::int64 target = (juce::int64) (timeMs * 1000.0);
+  auto after = std::upper_bound(index_.begin(), index_.end(), target,
+                                [] (juce::int64 t, const IndexEntry& entry)
+                                { return t < entry.firstTime; });
+  const int chunk = after == index_.begin() ? 0 : (int) (after - index_.begin()) - 1;
+
+  chunk_ = chunk - 1;
+  eventsLeft_ = 0;
+  havePending_ = false;
+  while (decodeEvent(pending_))
+  {
+    if (time_ >= target)
+    {
+      havePending_ = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SensorLogReader::readNext(SensorEvent& event)
+{
+  if (havePending_)
+  {
+    event = pending_;
+    havePending_ = false;
+    return true;
+  }
+  return map_ != nullptr && decodeEvent(event);
+}
+
+bool SensorLogReader::startChunk(int chunk)
+{
+  if (chunk >= (int) index_.size())
+    return false;
+
+  // readIndex() and rebuildIndex() only keep chunks that are all in the file
+  auto* header = data_ + index_[(size_t) chunk].offset;
+  chunk_ = chunk;
+  pos_ = header + chunkHeaderSize;
+  chunkEnd_ = pos_ + readUint32(header + 4);
+  eventsLeft_ = readUint32(header + 8);
+  time_ = readInt64(header + 12);
+  memset(lastDeviceTime_, 0, sizeof(lastDeviceTime_));
+  memset(lastFixed_, 0, sizeof(lastFixed_));
+  memset(lastBits_, 0, sizeof(lastBits_));
+  return true;
+}
+
+bool SensorLogReader::decodeEvent(SensorEvent& event)
+{
+  for (;;)
+  {
+    while (eventsLeft_ == 0)
+    {
+      if (!startChunk(chunk_ + 1))
+        return false;
+    }
+
+    juce::uint64 timeDelta, deviceTimeDelta, valueDelta;
+    if (readVarint(pos_, chunkEnd_, timeDelta) && pos_ < chunkEnd_)
+    {
+      const juce::uint8 key = *pos_++;
+      const int device = key >> 4;
+      int sensor = key & 0x0f;
+      if (sensor == 15 && pos_ < chunkEnd_)
+        sensor = *pos_++;
+
+      if (readVarint(pos_, chunkEnd_, deviceTimeDelta)
+          && readVarint(pos_, chunkEnd_, valueDelta))
+      {
+        time_ += (juce::int64) timeDelta;
+        lastDeviceTime_[device] += (juce::uint32) unzigzag(deviceTimeDelta);
+
+        float value;
+        if ((valueDelta & 1) == 0)
+        {
+          lastFixed_[device][sensor] += unzigzag(valueDelta >> 1);
+          value = (float) ((double) lastFixed_[device][sensor] / fixedScale);
+        }
+        else
+        {
+          lastBits_[device][sensor] ^= (juce::uint32) (valueDelta >> 1);
+          value = floatFromBits(lastBits_[device][sensor]);
+        }
+
+        event.record.sensor = (juce::uint8) sensor;
+        event.record.value = value;
+        event.record.deviceTime = lastDeviceTime_[device];
+        event.device = (juce::uint8) device;
+        event.hostTimeMs = (double) time_ / 1000.0;
+        --eventsLeft_;
+        return true;
+      }
+    }
+
+    eventsLeft_ = 0; // damaged chunk, carry on with the next one
+  }
+}
+
+//==============================================================================
+SensorRecorder::SensorRecorder() : juce::Thread("SensorRecorder") { /* Nothing */ }
+
+SensorRecorder::~SensorRecorder()
+{
+  stop();
+}
+
+bool SensorRecorder::start(const juce::File& file)
+{
+  stop();
+  if (!writer_.open(file, juce::Time::getMillisecondCounterHiRes()))
+    return false;
+
+  file_ = file;
+  fifo_.reset();
+  startThread();
+  return true;
+}
+
+void SensorRecorder::stop()
+{
+  if (isThreadRunning())
+  {
+    signalThreadShouldExit();
+    wake_.signal();
+    waitForThreadToExit(-1);
+  }
+  drain();
+  writer_.close();
+}
+
+void SensorRecorder::push(const SensorEvent* events, int numEvents) noexcept
+{
+  int start1, size1, start2, size2;
+  fifo_.prepareToWrite(numEvents, start1, size1, start2, size2);
+  std::copy(events, events + size1, queue_ + start1);
+  std::copy(events + size1, events + size1 + size2, queue_ + start2);
+  fifo_.finishedWrite(size1 + size2);
+
+  if (size1 + size2 < numEvents)
+    dropped_.fetch_add((juce::uint64) (numEvents - size1 - size2));
+  if (size1 + size2 > 0)
+    wake_.signal();
+}
+
+void SensorRecorder::run()
+{
+  while (!threadShouldExit())
+  {
+    // a quiet spell gets whatever's buffered onto the disk
+    if (!wake_.wait(500))
+      writer_.flush();
+    drain();
+  }
+}
+
+void SensorRecorder::drain()
+{
+  int start1, size1, start2, size2;
+  fifo_.prepareToRead(fifo_.getNumReady(), start1, size1, start2, size2);
+  for (int idx = 0; idx < size1; ++idx)
+    writer_.write(queue_[start1 + idx]);
+  for (int idx = 0; idx < size2; ++idx)
+    writer_.write(queue_[start2 + idx]);
+  fifo_.finishedRead(size1 + size2);
+}
+
+juce::File SensorRecorder::createSessionFile(const juce::File& directory)
+{
+  return directory.getChildFile(
+      "session_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".bslog")
+      .getNonexistentSibling();
+}
+
+} // namespace BioSignals
@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    SensorLog.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorParser.h"
+
+namespace BioSignals
+{
+
+/*
+ Sensor session logs (.bslog): every decoded reading of a show, small enough
+ to keep hours of it and indexed so replay can start anywhere.
+
+ All integers are little endian, times are microseconds since the session
+ started.
+
+   file header   "BSLG", uint16 version, uint16 header size,
+                 int64 wall clock start (ms since the epoch)
+   chunk         "CHNK", uint32 payload size, uint32 event count,
+                 int64 time of the chunk's first event, payload
+   ...
+   index         "INDX", uint32 chunk count,
+                 chunk count x { int64 file offset, int64 first time,
+                                 int64 last time, uint32 event count }
+   trailer       int64 index offset, "BSLE"
+
+ Chunks decode on their own. Inside one every event is delta coded against
+ the one before it:
+
+   varint        time since the previous event
+   uint8         device << 4 | sensor, sensor 15 meaning "in the next byte"
+   varint        zigzag of the change in the device's millis() timestamp
+   varint        the value, tagged by its lowest bit:
+                   0: zigzag of the change in value x 100, for readings with
+                      at most two decimals (what both wire formats carry)
+                   1: float bits XOR the last such bits, for anything else
+
+ each against the last value of the same device and sensor, so a typical
+ reading costs four or five bytes against the seven or eight of a text
+ dump. The index is only written when the log is closed properly; a log cut
+ short by a crash is indexed again by walking the chunks, losing at most the
+ chunk being written.
+ */
+
+//==============================================================================
+/** Encodes events into a .bslog, one chunk at a time. Not thread safe */
+class SensorLogWriter
+{
+public:
+  /** Chunks are closed after this many events or this much time */
+  static constexpr int maxChunkEvents = 1024;
+  static constexpr juce::int64 maxChunkMicros = 2000000;
+
+  SensorLogWriter() = default;
+  ~SensorLogWriter() { close(); }
+
+  /** Starts a new log. sessionStartMs is the host time that becomes t = 0 */
+  bool open(const juce::File& file, double sessionStartMs);
+
+  /** Events must be in time order; ones from earlier are logged at the same time as the last */
+  void write(const SensorEvent& event);
+
+  /** Write out the current chunk, so it survives a crash */
+  void flush();
+
+  /** Flushes and writes the index. Called by the destructor too */
+  void close();
+
+  bool isOpen() const noexcept { return stream_ != nullptr; }
+  juce::uint64 getNumEventsWritten() const noexcept { return eventsWritten_; }
+
+private:
+  struct IndexEntry
+  {
+    juce::int64 offset;
+    juce::int64 firstTime;
+    juce::int64 lastTime;
+    juce::uint32 numEvents;
+  };
+
+  void resetDeltas();
+
+  std::unique_ptr<juce::FileOutputStream> stream_;
+  double sessionStartMs_ = 0.0;
+  juce::MemoryOutputStream chunk_;
+  int chunkEvents_ = 0;
+  juce::int64 chunkFirstTime_ = 0;
+  juce::int64 lastTime_ = 0;
+  juce::uint32 lastDeviceTime_[maxSensorDevices];
+  juce::int32 lastFixed_[maxSensorDevices][256];
+  juce::uint32 lastBits_[maxSensorDevices][256];
+  std::vector<IndexEntry> index_;
+  juce::uint64 eventsWritten_ = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(SensorLogWriter)
+};
+
+//==============================================================================
+/**
+ Reads a .bslog through a read-only memory map, so even a multi-hour log
+ opens instantly and only the chunks actually played get paged in.
+
+ Events come back with hostTimeMs relative to the start of the session.
+ */
+class SensorLogReader
+{
+public:
+  SensorLogReader() = default;
+
+  bool open(const juce::File& file);
+  bool isOpen() const noexcept { return map_ != nullptr; }
+
+  /** Whether the index had to be rebuilt, i.e. the log wasn't closed properly */
+  bool wasRecovered() const noexcept { return recovered_; }
+
+  juce::int64 getWallClockStartMs() const noexcept { return wallClockStartMs_; }
+  double getDurationMs() const noexcept;
+  juce::uint64 getNumEvents() const noexcept;
+  int getNumChunks() const noexcept { return (int) index_.size(); }
+
+  /** Position on the first event at or after timeMs; false if there's none */
+  bool seek(double timeMs);
+
+  /** Next event in time order, false at the end of the log */
+  bool readNext(SensorEvent& event);
+
+private:
+  struct IndexEntry
+  {
+    juce::int64 offset;
+    juce::int64 firstTime;
+    juce::int64 lastTime;
+    juce::uint32 numEvents;
+  };
+
+  bool readIndex();
+  bool rebuildIndex();
+  bool startChunk(int chunk);
+  bool decodeEvent(SensorEvent& event);
+
+  std::unique_ptr<juce::MemoryMappedFile> map_;
+  const juce::uint8* data_ = nullptr;
+  size_t size_ = 0;
+  juce::int64 wallClockStartMs_ = 0;
+  bool recovered_ = false;
+  std::vector<IndexEntry> index_;
+
+  // decoder state within the current chunk
+  int chunk_ = 0;
+  const juce::uint8* pos_ = nullptr;
+  const juce::uint8* chunkEnd_ = nullptr;
+  juce::uint32 eventsLeft_ = 0;
+  juce::int64 time_ = 0;
+  juce::uint32 lastDeviceTime_[maxSensorDevices];
+  juce::int32 lastFixed_[maxSensorDevices][256];
+  juce::uint32 lastBits_[maxSensorDevices][256];
+  SensorEvent pending_;      // found by seek(), handed out by the next readNext()
+  bool havePending_ = false;
+
+  JUCE_DECLARE_NON_COPYABLE(SensorLogReader)
+};
+
+//==============================================================================
+/**
+ Writes a session log in the background while the show runs.
+
+ push() copies events into a lock-free queue and returns; the recorder's own
+ thread encodes them and does all the file I/O. One thread pushes at a time.
+ */
+class SensorRecorder : private juce::Thread
+{
+public:
+  SensorRecorder();
+  ~SensorRecorder() override;
+
+  bool start(const juce::File& file);
+  /** Writes whatever is still queued, then the index */
+  void stop();
+  bool isRecording() const noexcept { return isThreadRunning(); }
+
+  void push(const SensorEvent* events, int numEvents) noexcept;
+
+  juce::uint64 getDroppedEventCount() const noexcept { return dropped_.load(); }
+  const juce::File& getFile() const noexcept { return file_; }
+
+  /** A timestamped name for a log in directory */
+  static juce::File createSessionFile(const juce::File& directory);
+
+private:
+  static constexpr int queueSize = 16384;
+
+  void run() override;
+  void drain();
+
+  juce::AbstractFifo fifo_ { queueSize };
+  juce::HeapBlock<SensorEvent> queue_ { (size_t) queueSize };
+  std::atomic<juce::uint64> dropped_ { 0 };
+  juce::WaitableEvent wake_;
+  SensorLogWriter writer_;
+  juce::File file_;
+
+  JUCE_DECLARE_NON_COPYABLE(SensorRecorder)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    SensorParser.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorParser.h"
+
+namespace BioSignals
+{
+
+namespace
+{
+
+constexpr int maxMantissaDigits = 18;
+
+const double inversePowersOfTen[maxMantissaDigits + 1] = {
+  1e0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9,
+  1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16, 1e-17, 1e-18
+};
+
+inline bool isDigit(char c) noexcept { return c >= '0' && c <= '9'; }
+inline bool isBlank(char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+} // namespace
+
+SensorLineParser::Result SensorLineParser::parse(
+    const void* data, int numBytes, SensorRecord* out, int maxRecords) noexcept
+{
+  auto* start = static_cast<const char*>(data);
+  auto* p = start;
+  auto* end = start + numBytes;
+  int numRecords = 0;
+
+  while (p < end && numRecords < maxRecords)
+  {
+    auto* newline = static_cast<const char*>(memchr(p, '\n', (size_t) (end - p)));
+    auto* lineEnd = newline != nullptr ? newline : end;
+    auto* next = newline != nullptr ? newline + 1 : end;
+
+    if (discarding_)
+    {
+      discarding_ = newline == nullptr;
+      p = next;
+      continue;
+    }
+
+    const char* line = p;
+    int length = (int) (lineEnd - p);
+
+    if (pendingLength_ > 0 || newline == nullptr)
+    {
+      // the line straddles a buffer boundary, collect it in pending_
+      if (pendingLength_ + length > maxLineLength)
+      {
+        // too long to be one of ours: count it against whoever it claims to be from
+        auto* first = pendingLength_ > 0 ? pending_ : line;
+        auto* firstEnd = pendingLength_ > 0 ? pending_ + pendingLength_ : lineEnd;
+        while (first < firstEnd && isBlank(*first))
+          ++first;
+        if (first < firstEnd && isDigit(*first))
+          ++malformed_[*first - '0'];
+        else
+          ++skippedLines_;
+
+        pendingLength_ = 0;
+        discarding_ = newline == nullptr;
+        p = next;
+        continue;
+      }
+
+      memcpy(pending_ + pendingLength_, line, (size_t) length);
+      pendingLength_ += length;
+      p = next;
+
+      if (newline == nullptr)
+        break; // wait for the rest
+
+      line = pending_;
+      length = pendingLength_;
+      pendingLength_ = 0;
+    }
+    else
+    {
+      p = next;
+    }
+
+    if (parseLine(line, length, out[numRecords]))
+      ++numRecords;
+  }
+
+  return { numRecords, (int) (p - start) };
+}
+
+void SensorLineParser::reset() noexcept
+{
+  pendingLength_ = 0;
+  discarding_ = false;
+}
+
+bool SensorLineParser::parseLine(const char* line, int length,
+                                 SensorRecord& record) noexcept
+{
+  auto* s = line;
+  auto* e = line + length;
+  while (s < e && isBlank(*s))
+    ++s;
+  while (e > s && isBlank(e[-1]))
+    --e;
+
+  if (s == e)
+    return false; // blank line
+
+  if (!isDigit(*s))
+  {
+    ++skippedLines_; // banner or debug text
+    return false;
+  }
+
+  const int sensor = *s++ - '0';
+
+  bool negative = false;
+  if (s < e && (*s == '-' || *s == '+'))
+    negative = *s++ == '-';
+
+  juce::int64 mantissa = 0;
+  int digits = 0;
+  int fractionDigits = 0;
+  bool seenPoint = false;
+  for (; s < e; ++s)
+  {
+    const char c = *s;
+    if (isDigit(c))
+    {
+      if (digits < maxMantissaDigits)
+      {
+        mantissa = mantissa * 10 + (c - '0');
+        ++digits;
+        fractionDigits += seenPoint ? 1 : 0;
+      }
+      else if (!seenPoint)
+      {
+        digits = 0; // integer part too large to be a sensor reading
+        break;
+      }
+    }
+    else if (c == '.' && !seenPoint)
+    {
+      seenPoint = true;
+    }
+    else
+    {
+      digits = 0; // "nan", "ovf", trailing garbage...
+      break;
+    }
+  }
+
+  if (digits == 0)
+  {
+    ++malformed_[sensor];
+    return false;
+  }
+
+  const double value = (double) mantissa * inversePowersOfTen[fractionDigits];
+  record.sensor = (juce::uint8) sensor;
+  record.value = (float) (negative ? -value : value);
+  record.deviceTime = 0;
+  ++records_[sensor];
+  return true;
+}
+
+} // namespace BioSignals
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SensorParser.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace BioSignals
+{
+
+/** Signal identifiers, the same numbers arduino_analog.ino prints in front of each value */
+enum SensorNums
+{
+  TEMP1 = 0x01,
+  TEMP2 = 0x02,
+  PULSE = 0x03,
+  ACCLX = 0x04,
+  ACCLY = 0x05,
+  ACCLZ = 0x06,
+};
+
+/** The ASCII protocol only has room for a single digit sensor id */
+constexpr int numSensorIds = 10;
+
+struct SensorRecord
+{
+  juce::uint8 sensor;
+  float value;
+  juce::uint32 deviceTime; // board millis() when the wire format carries it, else 0
+};
+
+/** Boards one SensorIngest can keep apart, e.g. one per performer */
+constexpr int maxSensorDevices = 16;
+
+/** A decoded reading plus which board it came from and when the host got hold of it */
+struct SensorEvent
+{
+  SensorRecord record;
+  juce::uint8 device;
+  double hostTimeMs; // juce::Time::getMillisecondCounterHiRes() on arrival, or the ingest caller's clock
+};
+
+/**
+ Streaming decoder for the "<sensor-id><value>\n" lines printed by arduino_analog.ino.
+
+ Bytes are decoded straight out of the caller's buffer into SensorRecords, a whole batch per call,
+ without touching the heap. An unfinished line at the end of a buffer is kept in a small fixed
+ buffer and completed by the next call.
+
+ Lines that don't start with a digit (e.g. the "We created a pulseSensor Object !" banner) are
+ skipped without being parsed. Lines that do start with a sensor id but don't carry a valid number
+ are counted per sensor in getMalformedCount().
+ */
+class SensorLineParser
+{
+public:
+  /** Longest line we'll accept, anything longer is dropped as malformed */
+  static constexpr int maxLineLength = 32;
+
+  struct Result
+  {
+    int numRecords;
+    int bytesConsumed;
+  };
+
+  /**
+   Decode up to maxRecords records from data.
+
+   Stops early once out is full, in which case bytesConsumed < numBytes and the rest of the data
+   should be passed in again.
+   */
+  Result parse(const void* data, int numBytes,
+               SensorRecord* out, int maxRecords) noexcept;
+
+  /** Forget any partially received line, e.g. after reopening the port */
+  void reset() noexcept;
+
+  juce::uint64 getRecordCount(int sensor) const noexcept { return records_[sensor]; }
+  juce::uint64 getMalformedCount(int sensor) const noexcept { return malformed_[sensor]; }
+  juce::uint64 getSkippedLineCount() const noexcept { return skippedLines_; }
+
+private:
+  /** Returns true and fills record if line holds a valid record */
+  bool parseLine(const char* line, int length, SensorRecord& record) noexcept;
+
+  char pending_[maxLineLength];
+  int pendingLength_ = 0;
+  bool discarding_ = false; // skipping the rest of a text or overlong line
+
+  juce::uint64 records_[numSensorIds] = {};
+  juce::uint64 malformed_[numSensorIds] = {};
+  juce::uint64 skippedLines_ = 0;
+};
+
+} // namespace BioSignals
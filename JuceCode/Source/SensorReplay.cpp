@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    SensorReplay.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorReplay.h"
+
+namespace BioSignals
+{
+
+SensorLogPlayer::SensorLogPlayer(SensorIngest& ingest) :
+    juce::Thread("SensorLogPlayer"), ingest_(ingest)
+{ /* Nothing */ }
+
+SensorLogPlayer::~SensorLogPlayer()
+{
+  stop();
+}
+
+bool SensorLogPlayer::open(const juce::File& file)
+{
+  stop();
+  return reader_.open(file);
+}
+
+void SensorLogPlayer::play(double fromMs, double speed)
+{
+  stop();
+  fromMs_ = juce::jmax(0.0, fromMs);
+  speed_ = speed > 0.0 ? speed : 1.0;
+  position_ = fromMs_;
+  if (reader_.isOpen())
+    startThread();
+}
+
+void SensorLogPlayer::stop()
+{
+  stopThread(2000);
+}
+
+void SensorLogPlayer::run()
+{
+  if (!reader_.seek(fromMs_))
+    return;
+
+  const double started = juce::Time::getMillisecondCounterHiRes();
+  SensorEvent event;
+  while (!threadShouldExit() && reader_.readNext(event))
+  {
+    const double due = started + (event.hostTimeMs - fromMs_) / speed_;
+    for (;;)
+    {
+      const double early = due - juce::Time::getMillisecondCounterHiRes();
+      if (early < 1.0 || threadShouldExit())
+        break;
+      wait(juce::jmin(50, (int) early));
+    }
+
+    ingest_.handleRecords(event.device, &event.record, 1);
+    position_ = event.hostTimeMs;
+  }
+}
+
+} // namespace BioSignals
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    SensorReplay.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorIngest.h"
+#include "SensorLog.h"
+
+namespace BioSignals
+{
+
+/**
+ Plays a recorded .bslog back into a SensorIngest, on the original timing.
+
+ The readings go in through SensorIngest::handleRecords(), so from there on
+ they take exactly the path live serial data takes: value blocks for the
+ audio thread, the event queue for the dispatcher. The player's thread is
+ then the ingest's one producer, so don't read a serial port into the same
+ SensorIngest at the same time.
+ */
+class SensorLogPlayer : private juce::Thread
+{
+public:
+  explicit SensorLogPlayer(SensorIngest& ingest);
+  ~SensorLogPlayer() override;
+
+  bool open(const juce::File& file);
+
+  /** Start, or jump, to fromMs into the session; speed is x realtime */
+  void play(double fromMs, double speed = 1.0);
+  void stop();
+  bool isPlaying() const noexcept { return isThreadRunning(); }
+
+  /** Session time of the last reading handed over */
+  double getPositionMs() const noexcept { return position_.load(); }
+
+  const SensorLogReader& getReader() const noexcept { return reader_; }
+
+private:
+  void run() override;
+
+  SensorIngest& ingest_;
+  SensorLogReader reader_;
+  double fromMs_ = 0.0;
+  double speed_ = 1.0;
+  std::atomic<double> position_ { 0.0 };
+
+  JUCE_DECLARE_NON_COPYABLE(SensorLogPlayer)
+};
+
+} // namespace BioSignals
@@ -31,10 +31,21 @@ FrequencyGenerator* constructFreqGenerator(GeneratorType gen_type,
   }
 }
 
-Sequencer::Sequencer(BioSignals::WavetableOscillator& tgas,
+Sequencer::Sequencer(BioSignals::VoicePool& voices,
                      FrequencyGenerator* fg,
                      double tempo) :
-    freqGen_(fg), synth_(tgas), samplesPerNote_(sampleRate_) { }
+    freqGen_(fg), voices_(voices), notesPerMinute_(tempo)
+{
+  reclaimer_.startThread();
+}
+
+Sequencer::~Sequencer()
+{
+  reclaimer_.stopThread(-1);
+  reclaimRetired();
+  delete pendingGen_.exchange(nullptr);
+  delete freqGen_;
+}
 
 /*
 *  Set the tempo of this Sequencer.
@@ -44,15 +55,58 @@ Sequencer::Sequencer(BioSignals::WavetableOscillator& tgas,
 */
 void Sequencer::setTempo(double notesPerMinute)
 {
-  // sampleRate = samps/sec
-  // notesPerMinute = notes/min = notes/(60 sec)
-  // samplesPerSecond / notesPerSecond = samps/note
-  samplesPerNote_ = (size_t) (sampleRate_ / (notesPerMinute / 60.0));
+  jassert(notesPerMinute > 0.0);
+  notesPerMinute_ = juce::jmax(notesPerMinute, 1.0e-3);
 }
 
 void Sequencer::setSequence(FrequencyGenerator* fg)
 {
-  freqGen_ = std::unique_ptr<FrequencyGenerator>(fg);
+  // whatever was still waiting was never seen by the audio thread
+  delete pendingGen_.exchange(fg, std::memory_order_acq_rel);
+  reclaimer_.notify();
+}
+
+void Sequencer::adoptPendingGenerator() noexcept
+{
+  // no room to retire the current one: leave the new one waiting until
+  // the reclaimer catches up, rather than free anything here
+  if (pendingGen_.load(std::memory_order_relaxed) == nullptr
+      || retiredFifo_.getFreeSpace() == 0)
+    return;
+
+  FrequencyGenerator* next = pendingGen_.exchange(nullptr, std::memory_order_acq_rel);
+  if (next == nullptr)
+    return;
+
+  if (freqGen_ != nullptr)
+  {
+    int start1, size1, start2, size2;
+    retiredFifo_.prepareToWrite(1, start1, size1, start2, size2);
+    retired_[size1 > 0 ? start1 : start2] = freqGen_;
+    retiredFifo_.finishedWrite(1);
+  }
+  freqGen_ = next;
+}
+
+void Sequencer::reclaimRetired()
+{
+  int start1, size1, start2, size2;
+  retiredFifo_.prepareToRead(retiredFifo_.getNumReady(), start1, size1, start2, size2);
+  for (int idx = 0; idx < size1; ++idx)
+    delete retired_[start1 + idx];
+  for (int idx = 0; idx < size2; ++idx)
+    delete retired_[start2 + idx];
+  retiredFifo_.finishedRead(size1 + size2);
+}
+
+void Sequencer::Reclaimer::run()
+{
+  // the audio thread doesn't signal, it's polled
+  while (!threadShouldExit())
+  {
+    wait(reclaimIntervalMs);
+    owner_.reclaimRetired();
+  }
 }
 
 void Sequencer::prepareToPlay(
@@ -60,34 +114,79 @@ void Sequencer::prepareToPlay(
 {
   samplesPerBlockExpected_ = samplesPerBlockExpected;
   sampleRate_ = sampleRate;
-  synth_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+  phase_ = 1.0;
+  currentNote_ = 0;
+  samplesRendered_ = 0;
+  voices_.prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 
 void Sequencer::releaseResources()
 {
-  synth_.releaseResources();
+  voices_.releaseResources();
 }
 
 void Sequencer::getNextAudioBlock(
     const juce::AudioSourceChannelInfo &bufferToFill)
 {
-  if (!freqGen_)
-    return; // not ready yet
+  auto* mono = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+  renderNextBlock(mono, bufferToFill.numSamples);
+  for (int chan_idx = 1; chan_idx < bufferToFill.buffer->getNumChannels(); ++chan_idx)
+    bufferToFill.buffer->copyFrom(chan_idx, bufferToFill.startSample,
+                                  mono, bufferToFill.numSamples);
+}
 
+void Sequencer::renderNextBlock(float* dest, int numSamples) noexcept
+{
+  adoptPendingGenerator();
+  if (freqGen_ == nullptr)
+  {
+    juce::FloatVectorOperations::clear(dest, numSamples);
+    samplesRendered_ += numSamples;
+    return; // not ready yet
+  }
 
-  // if past threshold, then change frequency of synthesizer
-  if (currPeriodSamples_ > samplesPerNote_)
+  // render up to each step and change frequency on the exact sample it's due
+  int start = 0;
+  int remaining = numSamples;
+  for (;;)
   {
-    currPeriodSamples_ = 0;
-    double new_freq = freqGen_->getNextFreq();
-    synth_.setFrequency(new_freq);
-//      juce::Logger::getCurrentLogger()->writeToLog(
-//          "new frequency: " + std::to_string(new_freq));
+    // sampleRate = samps/sec
+    // notesPerMinute = notes/min = notes/(60 sec)
+    // notesPerSecond / samplesPerSecond = steps/samp
+    const double increment = notesPerMinute_ / (60.0 * sampleRate_);
+    const double samples_to_step = std::ceil((1.0 - phase_) / increment);
+    const int count = (int) juce::jmin((double) remaining, samples_to_step);
+
+    if (count > 0)
+    {
+      voices_.renderNextBlock(dest + start, count);
+      start += count;
+      remaining -= count;
+      samplesRendered_ += count;
+    }
+
+    if (count < samples_to_step)
+    {
+      phase_ += count * increment;
+      break;
+    }
+
+    // the step lands on the sample at start; keep what it overshot by
+    phase_ = juce::jmax(0.0, phase_ + count * increment - 1.0);
+    step();
+    if (remaining == 0)
+      break;
   }
+}
 
-  synth_.getNextAudioBlock(bufferToFill);
-  
-  currPeriodSamples_ += bufferToFill.numSamples;
+void Sequencer::step()
+{
+  double new_freq = freqGen_->getNextFreq();
+  voices_.noteOff(currentNote_);
+  // quick steps overlap their tails, keep the sum of them below full scale
+  currentNote_ = voices_.noteOn(new_freq, voices_.getOverlapGain(60.0 / notesPerMinute_));
+//      juce::Logger::getCurrentLogger()->writeToLog(
+//          "new frequency: " + std::to_string(new_freq));
 }
 
 } // namespace BioSignals
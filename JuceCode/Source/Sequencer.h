@@ -11,7 +11,7 @@
 
 #include <JuceHeader.h>
 #include <vector>
-#include "WavetableOsc.h"
+#include "VoicePool.h"
 
 namespace BioSignals
 {
@@ -76,21 +76,25 @@ public:
   FreqRandom(const std::vector<float>& sequence) :
       sequence_(sequence) { };
   ~FreqRandom() = default;
+
+  /** Same seed, same walk through the sequence, e.g. for an offline render */
+  void setSeed(juce::int64 seed) { random_.setSeed(seed); }
   
   virtual double getNextFreq() override
   {
-    float rand = juce::Random::getSystemRandom().nextFloat();
+    float rand = random_.nextFloat();
     if (rand < threshold)
     {
       return sequence_[++currIdx_ %= sequence_.size()];
     }
     else
     {
-      currIdx_ = juce::Random::getSystemRandom().nextInt() % sequence_.size();
+      currIdx_ = random_.nextInt((int) sequence_.size());
       return sequence_[currIdx_];
     }
   }
 private:
+  juce::Random random_; // seeded from the clock unless told otherwise
   float threshold = 0.5f;
   std::vector<float> sequence_;
   juce::uint8 currIdx_ = 0;
@@ -102,23 +106,33 @@ FrequencyGenerator* constructFreqGenerator(GeneratorType gen_type,
 class Sequencer : public juce::AudioSource
 {
 public:
-  Sequencer(BioSignals::WavetableOscillator& tgas) :
-          Sequencer(tgas, nullptr) { /* nothing */ }
-  Sequencer(BioSignals::WavetableOscillator& tgas,
+  Sequencer(BioSignals::VoicePool& voices) :
+          Sequencer(voices, nullptr) { /* nothing */ }
+  Sequencer(BioSignals::VoicePool& voices,
             FrequencyGenerator* fg,
             double tempo = 60.0);
 //  Sequencer(Sequencer& other);
 //  Sequencer& operator=(Sequencer& other);
-  ~Sequencer() = default;
+  ~Sequencer();
 
   /*
-  *  Set the tempo of this Sequencer.
+  *  Set the tempo of this Sequencer. Takes effect from the next sample,
+  *  partway through the current step.
   *
   *  @param notesPerMinute how quickly to change sequencer steps,
   *                        e.g. 60.0 times per minute
   */
   void setTempo(double notesPerMinute);
   
+  /*
+  *  Hand over a new generator, which the Sequencer owns from then on.
+  *  Message thread only; it never blocks on the audio thread.
+  *
+  *  The audio thread picks it up at the start of its next block, so a step
+  *  always sees one whole generator. The one it replaces is deleted on a
+  *  background thread, never the audio one. Another setSequence() before
+  *  that block replaces the one waiting, which is deleted here.
+  */
   void setSequence(FrequencyGenerator* fg);
 
   virtual void prepareToPlay(
@@ -129,14 +143,50 @@ public:
   virtual void getNextAudioBlock(
       const juce::AudioSourceChannelInfo &bufferToFill) override;
 
+  /** Overwrites dest with the next numSamples, one channel's worth */
+  void renderNextBlock(float* dest, int numSamples) noexcept;
+
+  /**
+   Samples rendered since prepareToPlay(). Read from the generator's
+   getNextFreq(), it's the sample the new note starts on
+   */
+  juce::int64 getSamplePosition() const noexcept { return samplesRendered_; }
+
 private:
-  std::unique_ptr<FrequencyGenerator> freqGen_;
-  BioSignals::WavetableOscillator& synth_;
-  int samplesPerBlockExpected_;
+  static constexpr int retiredQueueSize = 32;
+  static constexpr int reclaimIntervalMs = 100;
+
+  /** Deletes the generators the audio thread is done with */
+  class Reclaimer : public juce::Thread
+  {
+  public:
+    Reclaimer(Sequencer& owner) : juce::Thread("SequenceReclaimer"), owner_(owner) { }
+    void run() override;
+  private:
+    Sequencer& owner_;
+  };
+
+  void step();
+  void adoptPendingGenerator() noexcept; // audio thread
+  void reclaimRetired();                 // reclaimer thread, or once it's stopped
+
+  FrequencyGenerator* freqGen_ = nullptr;  // the audio thread's, owned
+  std::atomic<FrequencyGenerator*> pendingGen_ { nullptr };
+  // retired by the audio thread, waiting for the reclaimer
+  juce::AbstractFifo retiredFifo_ { retiredQueueSize };
+  FrequencyGenerator* retired_[retiredQueueSize] = {};
+  Reclaimer reclaimer_ { *this };
+  BioSignals::VoicePool& voices_;
+  int currentNote_ = 0; // released on the next step, its tail under the next note
+  int samplesPerBlockExpected_ = 0;
   double sampleRate_ = 48000.0 /* default sample rate */;
+  juce::int64 samplesRendered_ = 0; // audio thread
 
-  size_t samplesPerNote_;
-  size_t currPeriodSamples_;
+  double notesPerMinute_;
+  // how far we are through the current step, 0 to 1. it advances by
+  // notesPerMinute_ / (60 * sampleRate_) per sample, and carries any fraction
+  // of a sample over into the next step, so steps don't drift
+  double phase_ = 1.0; // start off with a step
 };
 
 } // namespace BioSignals
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    SmoothedParameters.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AtomicValueBlock.h"
+
+namespace BioSignals
+{
+
+/** What the synth smooths. The cutoffs are in octaves, so they glide evenly */
+enum SynthParameter
+{
+  VOLUME,           // gain, 0 to 1
+  CUTOFF_OCTAVES,   // log2 of the filter's base cutoff in Hz
+  MOTION_OCTAVES,   // how far movement opens the filter on top of that
+  TEMPO,            // sequencer steps per minute
+  numSynthParameters
+};
+
+/**
+ Parameters any thread can set and the audio thread reads as a ramp, one
+ value per sample, so a slider or a sensor never steps the sound.
+
+ setTarget() only publishes to an AtomicValueBlock. At the top of each block
+ the audio thread calls update(), and a parameter whose target has moved
+ glides to it, linearly, over its ramp time. getNextValues() writes the ramp
+ a block at a time with FloatVectorOperations; once a parameter has arrived
+ it returns false and leaves the caller to use getCurrent() as a constant,
+ so steady parameters cost an atomic load a block.
+ */
+template <int numParameters>
+class SmoothedParameterBlock
+{
+public:
+  SmoothedParameterBlock()
+  {
+    for (auto& ramp : ramps_)
+      ramp.seconds = 0.05;
+  }
+
+  /** Any thread, takes effect from the audio thread's next block */
+  void setTarget(int index, float value) noexcept { targets_.publish(index, value); }
+
+  //==============================================================================
+  // the rest is the audio thread's, or before playback starts
+
+  /** How long a change takes to glide in. Applies from the next change */
+  void setRampTime(int index, double seconds) noexcept
+  {
+    ramps_[index].seconds = seconds;
+    ramps_[index].length = juce::roundToInt(seconds * sampleRate_);
+  }
+
+  /** Jumps straight to value, e.g. before playback starts */
+  void setCurrentAndTarget(int index, float value) noexcept
+  {
+    targets_.publish(index, value);
+    auto& ramp = ramps_[index];
+    targets_.readIfNewer(index, ramp.seen, ramp.target);
+    ramp.current = value;
+    ramp.remaining = 0;
+  }
+
+  /** maxBlockSize is the most getNextValues() will be asked for at once */
+  void prepare(double sampleRate, int maxBlockSize)
+  {
+    sampleRate_ = sampleRate;
+    for (int idx = 0; idx < numParameters; ++idx)
+      setRampTime(idx, ramps_[idx].seconds);
+
+    // 1, 2, 3... so a ramp is one multiply and one add
+    maxBlockSize_ = juce::jmax(maxBlockSize, 1);
+    steps_.allocate((size_t) maxBlockSize_, false);
+    for (int idx = 0; idx < maxBlockSize_; ++idx)
+      steps_[idx] = (float) (idx + 1);
+  }
+
+  /** Picks up new targets. Once at the top of every block */
+  void update() noexcept
+  {
+    for (int idx = 0; idx < numParameters; ++idx)
+    {
+      auto& ramp = ramps_[idx];
+      float target;
+      if (!targets_.readIfNewer(idx, ramp.seen, target) || target == ramp.target)
+        continue;
+
+      ramp.target = target;
+      ramp.remaining = ramp.length;
+      if (ramp.remaining > 0)
+        ramp.step = (target - ramp.current) / (float) ramp.remaining;
+      else
+        ramp.current = target;
+    }
+  }
+
+  bool isRamping(int index) const noexcept { return ramps_[index].remaining > 0; }
+  float getCurrent(int index) const noexcept { return ramps_[index].current; }
+
+  /**
+   Writes the next numSamples values (at most the prepared block size) to
+   dest and moves on. False if the parameter isn't ramping, in which case
+   dest is left alone and every value would have been getCurrent()
+   */
+  bool getNextValues(int index, float* dest, int numSamples) noexcept
+  {
+    auto& ramp = ramps_[index];
+    if (ramp.remaining <= 0)
+      return false;
+
+    jassert(numSamples <= maxBlockSize_);
+    const int ramping = juce::jmin(numSamples, ramp.remaining);
+    juce::FloatVectorOperations::copyWithMultiply(dest, steps_, ramp.step, ramping);
+    juce::FloatVectorOperations::add(dest, ramp.current, ramping);
+    advance(ramp, ramping);
+    if (ramping < numSamples)
+      juce::FloatVectorOperations::fill(dest + ramping, ramp.current, numSamples - ramping);
+    return true;
+  }
+
+  /** Moves on numSamples without writing anything, returns where it's got to */
+  float skip(int index, int numSamples) noexcept
+  {
+    auto& ramp = ramps_[index];
+    if (ramp.remaining > 0)
+      advance(ramp, juce::jmin(numSamples, ramp.remaining));
+    return ramp.current;
+  }
+
+private:
+  struct Ramp
+  {
+    double seconds;
+    int length = 0;        // samples
+    juce::uint32 seen = 0; // targets_ update count
+    float target = 0.0f;
+    float current = 0.0f;
+    float step = 0.0f;
+    int remaining = 0;
+  };
+
+  static void advance(Ramp& ramp, int numSamples) noexcept
+  {
+    ramp.remaining -= numSamples;
+    // land exactly on the target rather than wherever the steps add up to
+    ramp.current = ramp.remaining > 0 ? ramp.current + ramp.step * (float) numSamples
+                                      : ramp.target;
+  }
+
+  AtomicValueBlock<numParameters> targets_;
+  Ramp ramps_[numParameters];
+  juce::HeapBlock<float> steps_;
+  int maxBlockSize_ = 0;
+  double sampleRate_ = 48000.0;
+};
+
+using SynthParameterBlock = SmoothedParameterBlock<numSynthParameters>;
+
+} // namespace BioSignals
@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+    StereoFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoFilter.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+ #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+#endif
+
+namespace BioSignals
+{
+
+void StereoFilter::prepare(double sampleRate, int maxBlockSize)
+{
+  sampleRate_ = sampleRate;
+  maxBlockSize_ = juce::jmax(maxBlockSize, 1);
+  coefficients_.allocate((size_t) maxBlockSize_ * 3, true);
+
+  // up to just short of Nyquist, where tan() runs off to infinity
+  highestOctave_ = (float) std::log2(0.49 * sampleRate);
+  const int numPoints = (int) std::ceil((highestOctave_ - lowestOctave) * tablePointsPerOctave) + 2;
+  warpTable_.resize((size_t) numPoints);
+  for (int idx = 0; idx < numPoints; ++idx)
+  {
+    const double hz = std::exp2(lowestOctave + (double) idx / tablePointsPerOctave);
+    warpTable_[(size_t) idx] = (float) std::tan(juce::MathConstants<double>::pi
+                                                * juce::jmin(hz, 0.49 * sampleRate) / sampleRate);
+  }
+  reset();
+}
+
+void StereoFilter::reset() noexcept
+{
+  ic1_[0] = ic1_[1] = ic2_[0] = ic2_[1] = 0.0f;
+}
+
+void StereoFilter::setResonance(float q) noexcept
+{
+  jassert(q > 0.0f);
+  damping_ = 1.0f / juce::jmax(q, 0.01f);
+}
+
+float StereoFilter::warpedCutoff(float octaves) const noexcept
+{
+  const float position = (juce::jlimit(lowestOctave, highestOctave_, octaves) - lowestOctave)
+                         * (float) tablePointsPerOctave;
+  const int index = (int) position;
+  const float frac = position - (float) index;
+  return warpTable_[(size_t) index]
+         + frac * (warpTable_[(size_t) index + 1] - warpTable_[(size_t) index]);
+}
+
+void StereoFilter::computeCoefficients(float g, float& a1, float& a2, float& a3) const noexcept
+{
+  a1 = 1.0f / (1.0f + g * (g + damping_));
+  a2 = g * a1;
+  a3 = g * a2;
+}
+
+void StereoFilter::process(float* left, float* right, float cutoffOctaves,
+                           int numSamples) noexcept
+{
+  float a1, a2, a3;
+  computeCoefficients(warpedCutoff(cutoffOctaves), a1, a2, a3);
+  run(left, right, &a1, &a2, &a3, 0, numSamples);
+}
+
+void StereoFilter::process(float* left, float* right, const float* cutoffOctaves,
+                           int numSamples) noexcept
+{
+  float* a1 = coefficients_;
+  float* a2 = a1 + maxBlockSize_;
+  float* a3 = a2 + maxBlockSize_;
+  for (int offset = 0; offset < numSamples; offset += maxBlockSize_)
+  {
+    const int count = juce::jmin(maxBlockSize_, numSamples - offset);
+    for (int idx = 0; idx < count; ++idx)
+      computeCoefficients(warpedCutoff(cutoffOctaves[offset + idx]), a1[idx], a2[idx], a3[idx]);
+    run(left + offset, right + offset, a1, a2, a3, 1, count);
+  }
+}
+
+void StereoFilter::processMono(float* samples, const float* gains, float fixedGain,
+                               const float* cutoffOctaves, float fixedCutoffOctaves,
+                               int numSamples) noexcept
+{
+  const int gainStride = gains != nullptr ? 1 : 0;
+  if (gains == nullptr)
+    gains = &fixedGain;
+
+  if (cutoffOctaves == nullptr)
+  {
+    float a1, a2, a3;
+    computeCoefficients(warpedCutoff(fixedCutoffOctaves), a1, a2, a3);
+    runMono(samples, gains, gainStride, &a1, &a2, &a3, 0, numSamples);
+    return;
+  }
+
+  float* a1 = coefficients_;
+  float* a2 = a1 + maxBlockSize_;
+  float* a3 = a2 + maxBlockSize_;
+  for (int offset = 0; offset < numSamples; offset += maxBlockSize_)
+  {
+    const int count = juce::jmin(maxBlockSize_, numSamples - offset);
+    for (int idx = 0; idx < count; ++idx)
+      computeCoefficients(warpedCutoff(cutoffOctaves[offset + idx]), a1[idx], a2[idx], a3[idx]);
+    runMono(samples + offset, gains + offset * gainStride, gainStride, a1, a2, a3, 1, count);
+  }
+}
+
+/*
+ One TPT state-variable step, per channel:
+
+   v3 = x - ic2
+   v1 = a1 ic1 + a2 v3      band pass
+   v2 = ic2 + a2 ic1 + a3 v3  low pass, the output
+   ic1 = 2 v1 - ic1
+   ic2 = 2 v2 - ic2
+
+ The coefficients are read every stride samples, so 0 holds them still.
+ */
+void StereoFilter::run(float* left, float* right, const float* a1, const float* a2,
+                       const float* a3, int coefficientStride, int numSamples) noexcept
+{
+#if defined(__SSE2__) || defined(_M_X64)
+  __m128 ic1 = _mm_setr_ps(ic1_[0], ic1_[1], 0.0f, 0.0f);
+  __m128 ic2 = _mm_setr_ps(ic2_[0], ic2_[1], 0.0f, 0.0f);
+  for (int idx = 0, coeff = 0; idx < numSamples; ++idx, coeff += coefficientStride)
+  {
+    const __m128 x = _mm_unpacklo_ps(_mm_load_ss(left + idx), _mm_load_ss(right + idx));
+    const __m128 c1 = _mm_set1_ps(a1[coeff]);
+    const __m128 c2 = _mm_set1_ps(a2[coeff]);
+    const __m128 c3 = _mm_set1_ps(a3[coeff]);
+    const __m128 v3 = _mm_sub_ps(x, ic2);
+    const __m128 v1 = _mm_add_ps(_mm_mul_ps(c1, ic1), _mm_mul_ps(c2, v3));
+    const __m128 v2 = _mm_add_ps(ic2, _mm_add_ps(_mm_mul_ps(c2, ic1), _mm_mul_ps(c3, v3)));
+    ic1 = _mm_sub_ps(_mm_add_ps(v1, v1), ic1);
+    ic2 = _mm_sub_ps(_mm_add_ps(v2, v2), ic2);
+    _mm_store_ss(left + idx, v2);
+    _mm_store_ss(right + idx, _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(1, 1, 1, 1)));
+  }
+  alignas(16) float states[4];
+  _mm_store_ps(states, ic1);
+  ic1_[0] = states[0];
+  ic1_[1] = states[1];
+  _mm_store_ps(states, ic2);
+  ic2_[0] = states[0];
+  ic2_[1] = states[1];
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  float32x2_t ic1 = vld1_f32(ic1_);
+  float32x2_t ic2 = vld1_f32(ic2_);
+  for (int idx = 0, coeff = 0; idx < numSamples; ++idx, coeff += coefficientStride)
+  {
+    const float32x2_t x = vset_lane_f32(right[idx], vdup_n_f32(left[idx]), 1);
+    const float32x2_t v3 = vsub_f32(x, ic2);
+    const float32x2_t v1 = vmla_n_f32(vmul_n_f32(ic1, a1[coeff]), v3, a2[coeff]);
+    const float32x2_t v2 = vmla_n_f32(vmla_n_f32(ic2, ic1, a2[coeff]), v3, a3[coeff]);
+    ic1 = vsub_f32(vadd_f32(v1, v1), ic1);
+    ic2 = vsub_f32(vadd_f32(v2, v2), ic2);
+    left[idx] = vget_lane_f32(v2, 0);
+    right[idx] = vget_lane_f32(v2, 1);
+  }
+  vst1_f32(ic1_, ic1);
+  vst1_f32(ic2_, ic2);
+#else
+  for (int idx = 0, coeff = 0; idx < numSamples; ++idx, coeff += coefficientStride)
+  {
+    float* channels[2] = { left, right };
+    for (int chan = 0; chan < 2; ++chan)
+    {
+      const float v3 = channels[chan][idx] - ic2_[chan];
+      const float v1 = a1[coeff] * ic1_[chan] + a2[coeff] * v3;
+      const float v2 = ic2_[chan] + a2[coeff] * ic1_[chan] + a3[coeff] * v3;
+      ic1_[chan] = 2.0f * v1 - ic1_[chan];
+      ic2_[chan] = 2.0f * v2 - ic2_[chan];
+      channels[chan][idx] = v2;
+    }
+  }
+#endif
+  flushDenormals();
+}
+
+void StereoFilter::runMono(float* samples, const float* gains, int gainStride,
+                           const float* a1, const float* a2, const float* a3,
+                           int coefficientStride, int numSamples) noexcept
+{
+  // the states stay in registers for the whole block
+  float ic1 = ic1_[0], ic2 = ic2_[0];
+  for (int idx = 0, gain = 0, coeff = 0; idx < numSamples;
+       ++idx, gain += gainStride, coeff += coefficientStride)
+  {
+    const float v3 = samples[idx] * gains[gain] - ic2;
+    const float v1 = a1[coeff] * ic1 + a2[coeff] * v3;
+    const float v2 = ic2 + a2[coeff] * ic1 + a3[coeff] * v3;
+    ic1 = 2.0f * v1 - ic1;
+    ic2 = 2.0f * v2 - ic2;
+    samples[idx] = v2;
+  }
+  ic1_[0] = ic1;
+  ic2_[0] = ic2;
+  flushDenormals();
+}
+
+void StereoFilter::flushDenormals() noexcept
+{
+  // a filter left ringing into silence decays into denormals, which are slow
+  for (int chan = 0; chan < 2; ++chan)
+  {
+    if (std::abs(ic1_[chan]) < 1.0e-15f)
+      ic1_[chan] = 0.0f;
+    if (std::abs(ic2_[chan]) < 1.0e-15f)
+      ic2_[chan] = 0.0f;
+  }
+}
+
+} // namespace BioSignals
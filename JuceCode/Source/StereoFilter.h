@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    StereoFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace BioSignals
+{
+
+/**
+ A resonant low pass for a stereo pair: a state-variable filter discretised
+ with the topology-preserving transform, so it stays stable and in tune
+ however fast its cutoff moves.
+
+ Both channels run through together, their states side by side in one SSE2
+ or NEON register (or two scalars without either). The cutoff is in octaves,
+ log2 of Hz, the way SmoothedParameterBlock glides it; the tan() the
+ transform needs comes from a table built in prepare(), so a new cutoff
+ every sample costs a lookup and a divide instead of a trip through
+ IIRCoefficients. States that decay into denormals are flushed at the end
+ of each block.
+
+ processMono() is the output stage for a signal that's the same in every
+ channel: gain and filter in one pass, on the left channel's state.
+ */
+class StereoFilter
+{
+public:
+  StereoFilter() = default;
+
+  /** maxBlockSize is the most either process() will be handed at once */
+  void prepare(double sampleRate, int maxBlockSize);
+  void reset() noexcept;
+
+  /** 1/sqrt(2) is flat, higher peaks at the cutoff. Takes effect from the next block */
+  void setResonance(float q) noexcept;
+
+  /** Filters numSamples of each channel in place at one cutoff */
+  void process(float* left, float* right, float cutoffOctaves, int numSamples) noexcept;
+
+  /** The same, with a cutoff per sample */
+  void process(float* left, float* right, const float* cutoffOctaves, int numSamples) noexcept;
+
+  /**
+   Scales samples by gains (one a sample), or by fixedGain if gains is
+   nullptr, and filters them at cutoffOctaves (one a sample), or at
+   fixedCutoffOctaves if that's nullptr. One pass, in place, nothing written
+   in between
+   */
+  void processMono(float* samples, const float* gains, float fixedGain,
+                   const float* cutoffOctaves, float fixedCutoffOctaves,
+                   int numSamples) noexcept;
+
+private:
+  static constexpr int tablePointsPerOctave = 48;
+  static constexpr float lowestOctave = 4.0f; // 16 Hz
+
+  /** tan(pi * cutoff / sampleRate), interpolated from the table */
+  float warpedCutoff(float octaves) const noexcept;
+  void computeCoefficients(float g, float& a1, float& a2, float& a3) const noexcept;
+  void run(float* left, float* right, const float* a1, const float* a2,
+           const float* a3, int coefficientStride, int numSamples) noexcept;
+  void runMono(float* samples, const float* gains, int gainStride,
+               const float* a1, const float* a2, const float* a3,
+               int coefficientStride, int numSamples) noexcept;
+  void flushDenormals() noexcept;
+
+  double sampleRate_ = 48000.0;
+  float damping_ = 1.41421356f; // 1/Q
+  float highestOctave_ = lowestOctave;
+  std::vector<float> warpTable_;
+  juce::HeapBlock<float> coefficients_; // a1, a2 and a3, a block of each
+  int maxBlockSize_ = 0;
+
+  // integrator states, left then right
+  float ic1_[2] = {}, ic2_[2] = {};
+
+  JUCE_DECLARE_NON_COPYABLE(StereoFilter)
+};
+
+} // namespace BioSignals
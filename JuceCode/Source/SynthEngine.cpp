@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    SynthEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "SynthEngine.h"
+#include "RealtimeGuard.h"
+
+namespace BioSignals
+{
+
+namespace
+{
+
+const float minTemperature = 20.0f;
+const float maxTemperature = 27.0f;
+const float minCutoffOctaves = std::log2(SynthEngine::minCutoff);
+const float maxCutoffOctaves = std::log2(SynthEngine::maxCutoff);
+// moving about opens the filter up by as much as two octaves
+const FeatureMapping motionToOctaves { 0.5f, 8.0f, 0.0f, 2.0f };
+
+} // namespace
+
+SynthEngine::SynthEngine(const WavetableBank& bank, const SensorIngest* sensors) :
+    voices_(bank), sequencer_(voices_), sensors_(sensors)
+{
+  // where everything starts, and how quickly it follows a change
+  parameters_.setCurrentAndTarget(VOLUME, 0.0f);
+  parameters_.setCurrentAndTarget(CUTOFF_OCTAVES, std::log2(1000.0f));
+  parameters_.setCurrentAndTarget(MOTION_OCTAVES, 0.0f);
+  parameters_.setCurrentAndTarget(TEMPO, 60.0f);
+  parameters_.setRampTime(VOLUME, 0.02);
+  parameters_.setRampTime(CUTOFF_OCTAVES, 0.05);
+  parameters_.setRampTime(MOTION_OCTAVES, 0.1);
+  parameters_.setRampTime(TEMPO, 0.25);
+}
+
+void SynthEngine::setUpConditioning(SensorIngest& ingest)
+{
+  // one bad temperature reading would otherwise sweep the cutoff across its
+  // whole range, so both controls get cleaned up on the way in
+  ConditioningChain temperature;
+  temperature.medianLength = 5;
+  temperature.outlierThreshold = 0.5f;  // degrees
+  temperature.smoothing = ConditioningChain::ONE_EURO;
+  temperature.minCutoffHz = 0.5f;
+  temperature.beta = 0.5f;
+  temperature.maxSlewPerSecond = 2.0f;
+
+  ConditioningChain pulse;
+  pulse.medianLength = 3;
+  pulse.smoothing = ConditioningChain::EMA;
+  pulse.emaTimeConstantMs = 500.0f;
+  pulse.maxSlewPerSecond = 60.0f;       // bpm
+
+  for (int device = 0; device < maxSensorDevices; ++device)
+  {
+    ingest.getConditioner(device).setChain(TEMP2, temperature);
+    ingest.getConditioner(device).setChain(PULSE, pulse);
+  }
+}
+
+float SynthEngine::temperatureToCutoff(float temperature) noexcept
+{
+  return juce::jlimit(minCutoff, maxCutoff,
+                      ((temperature - minTemperature) / (maxTemperature - minTemperature)) *
+                       (maxCutoff - minCutoff) + minCutoff);
+}
+
+float SynthEngine::pulseToTempo(float pulse) noexcept
+{
+  return juce::jlimit(minTempo, maxTempo, pulse);
+}
+
+void SynthEngine::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+  blockSize_ = juce::jmax(samplesPerBlockExpected, 64);
+  parameters_.prepare(sampleRate, blockSize_);
+  gain_.allocate((size_t) blockSize_, true);
+  cutoff_.allocate((size_t) blockSize_, true);
+  motionCutoff_.allocate((size_t) blockSize_, true);
+  lowPassFilter_.prepare(sampleRate, blockSize_);
+  sequencer_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+}
+
+void SynthEngine::releaseResources()
+{
+  sequencer_.releaseResources();
+}
+
+void SynthEngine::applySensorValues() noexcept
+{
+  if (sensors_ == nullptr)
+    return;
+
+  const auto& values = sensors_->getValues();
+  float value;
+
+  // whichever of a reading and a slider move comes last wins
+  if (values.readIfNewer(TEMP2, seen_[TEMP2], value))
+    parameters_.setTarget(CUTOFF_OCTAVES, std::log2(temperatureToCutoff(value)));
+  if (sensors_->getMotion().readIfNewer(MOTION_RMS, motionSeen_, value))
+    parameters_.setTarget(MOTION_OCTAVES, motionToOctaves.map(value));
+  if (values.readIfNewer(PULSE, seen_[PULSE], value))
+    parameters_.setTarget(TEMPO, pulseToTempo(value));
+}
+
+void SynthEngine::getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill)
+{
+  ScopedRealtimeSection realtimeSection;
+  juce::ScopedNoDenormals noDenormals;
+  applySensorValues();
+  parameters_.update();
+
+  // steps only need the tempo once a block, the sequencer's phase clock
+  // carries it smoothly from one to the next
+  sequencer_.setTempo(parameters_.getCurrent(TEMPO));
+  parameters_.skip(TEMPO, bufferToFill.numSamples);
+
+  // every channel plays the same thing: render it once into the first, put
+  // it through gain and filter in one pass, and copy it out at the very end
+  auto* mono = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+  sequencer_.renderNextBlock(mono, bufferToFill.numSamples);
+
+  // a host may hand us more than it said it would, take it a block at a time
+  for (int offset = 0; offset < bufferToFill.numSamples; offset += blockSize_)
+  {
+    const int count = juce::jmin(blockSize_, bufferToFill.numSamples - offset);
+    const bool gainGliding = parameters_.getNextValues(VOLUME, gain_, count);
+
+    // base cutoff plus what movement adds, a value a sample while either glides
+    const bool baseGliding = parameters_.getNextValues(CUTOFF_OCTAVES, cutoff_, count);
+    const bool motionGliding = parameters_.getNextValues(MOTION_OCTAVES, motionCutoff_, count);
+    const float fixedCutoff = juce::jlimit(minCutoffOctaves, maxCutoffOctaves,
+                                           parameters_.getCurrent(CUTOFF_OCTAVES)
+                                           + parameters_.getCurrent(MOTION_OCTAVES));
+    if (baseGliding || motionGliding)
+    {
+      if (!baseGliding)
+        juce::FloatVectorOperations::fill(cutoff_, parameters_.getCurrent(CUTOFF_OCTAVES), count);
+      if (motionGliding)
+        juce::FloatVectorOperations::add(cutoff_, motionCutoff_, count);
+      else
+        juce::FloatVectorOperations::add(cutoff_, parameters_.getCurrent(MOTION_OCTAVES), count);
+      juce::FloatVectorOperations::clip(cutoff_, cutoff_, minCutoffOctaves, maxCutoffOctaves, count);
+    }
+
+    lowPassFilter_.processMono(mono + offset,
+                               gainGliding ? gain_.get() : nullptr,
+                               parameters_.getCurrent(VOLUME),
+                               baseGliding || motionGliding ? cutoff_.get() : nullptr,
+                               fixedCutoff, count);
+  }
+
+  for (int chanIdx = 1; chanIdx < bufferToFill.buffer->getNumChannels(); ++chanIdx)
+    bufferToFill.buffer->copyFrom(chanIdx, bufferToFill.startSample,
+                                  mono, bufferToFill.numSamples);
+}
+
+} // namespace BioSignals
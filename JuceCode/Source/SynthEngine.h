@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    SynthEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SensorIngest.h"
+#include "Sequencer.h"
+#include "SmoothedParameters.h"
+#include "StereoFilter.h"
+#include "VoicePool.h"
+#include "WavetableBank.h"
+
+namespace BioSignals
+{
+
+/**
+ Everything between the sensors and the speakers: the voice pool, the
+ sequencer stepping through it, the output gain and low pass, and how the
+ first board's readings map onto those.
+
+ There's no GUI or audio device in here. The app plays it through its
+ AudioAppComponent and BioSignalsTools renders it offline, so both get the
+ same sound from the same readings.
+
+ Before each block it picks up whatever the SensorIngest has published
+ since the last one. Everything else goes through getParameters(), whose
+ setTarget() is safe from any thread, or through the Sequencer's
+ setSequence().
+ */
+class SynthEngine : public juce::AudioSource
+{
+public:
+  static constexpr float minCutoff = 20.0f;
+  static constexpr float maxCutoff = 12000.0f;
+  static constexpr float minTempo = 10.0f;
+  static constexpr float maxTempo = 2000.0f;
+
+  /** bank, and sensors if given, have to outlive the engine */
+  explicit SynthEngine(const WavetableBank& bank, const SensorIngest* sensors = nullptr);
+  ~SynthEngine() override = default;
+
+  SynthParameterBlock& getParameters() noexcept { return parameters_; }
+  Sequencer& getSequencer() noexcept { return sequencer_; }
+  VoicePool& getVoices() noexcept { return voices_; }
+
+  /**
+   The conditioning the mappings below are tuned for, on every device of
+   ingest. Call it before any bytes come in
+   */
+  static void setUpConditioning(SensorIngest& ingest);
+
+  static float temperatureToCutoff(float temperature) noexcept;
+  static float pulseToTempo(float pulse) noexcept;
+
+  virtual void prepareToPlay(
+      int samplesPerBlockExpected, double sampleRate) override;
+
+  virtual void releaseResources() override;
+
+  virtual void getNextAudioBlock(
+      const juce::AudioSourceChannelInfo &bufferToFill) override;
+
+private:
+  void applySensorValues() noexcept;
+
+  VoicePool voices_;
+  Sequencer sequencer_;
+  StereoFilter lowPassFilter_;
+
+  // set by the GUI and the sensors, glided to by the audio thread
+  SynthParameterBlock parameters_;
+  juce::HeapBlock<float> gain_;   // a block of VOLUME
+  juce::HeapBlock<float> cutoff_; // and of the cutoff, in octaves
+  juce::HeapBlock<float> motionCutoff_;
+  int blockSize_ = 0;
+
+  const SensorIngest* sensors_;
+  juce::uint32 seen_[numSensorIds] = {};
+  juce::uint32 motionSeen_ = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(SynthEngine)
+};
+
+} // namespace BioSignals
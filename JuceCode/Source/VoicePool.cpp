@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+    VoicePool.cpp
+
+  ==============================================================================
+*/
+
+#include "VoicePool.h"
+
+namespace BioSignals
+{
+
+VoicePool::VoicePool(const WavetableBank& bank, int numVoices)
+{
+  jassert(numVoices > 0);
+  for (int idx = 0; idx < numVoices; ++idx)
+    voices_.add(new Voice(bank));
+  setEnvelope(envelopeParameters_);
+}
+
+void VoicePool::setEnvelope(const juce::ADSR::Parameters& parameters) noexcept
+{
+  envelopeParameters_ = parameters;
+  for (auto* voice : voices_)
+    voice->envelope.setParameters(parameters);
+}
+
+int VoicePool::noteOn(float frequency, float velocity) noexcept
+{
+  Voice* voice = findVoiceToPlay();
+  voice->noteId = ++lastNoteId_;
+  voice->startedAt = ++notesStarted_;
+  voice->held = true;
+  voice->osc.setFrequency(frequency);
+  voice->osc.setAmplitude(0.5f * velocity);
+  voice->envelope.noteOn();
+  return voice->noteId;
+}
+
+void VoicePool::noteOff(int noteId) noexcept
+{
+  for (auto* voice : voices_)
+  {
+    if (voice->noteId == noteId && voice->held)
+    {
+      voice->held = false;
+      voice->envelope.noteOff();
+      return;
+    }
+  }
+}
+
+void VoicePool::allNotesOff() noexcept
+{
+  for (auto* voice : voices_)
+  {
+    if (voice->held)
+    {
+      voice->held = false;
+      voice->envelope.noteOff();
+    }
+  }
+}
+
+float VoicePool::getOverlapGain(double noteIntervalSeconds) const noexcept
+{
+  const double release = envelopeParameters_.release;
+  if (noteIntervalSeconds <= 0.0 || noteIntervalSeconds >= release)
+    return 1.0f;
+
+  // the k-th tail back is at 1 - k * interval / release, while that's above 0
+  const double fraction = noteIntervalSeconds / release;
+  const double numTails = std::ceil(1.0 / fraction) - 1.0;
+  const double overlap = 1.0 + numTails - fraction * numTails * (numTails + 1.0) / 2.0;
+  return (float) (1.0 / overlap);
+}
+
+VoicePool::Voice* VoicePool::findVoiceToPlay() noexcept
+{
+  Voice* oldest = nullptr;
+  Voice* oldestReleased = nullptr;
+  for (auto* voice : voices_)
+  {
+    if (!voice->envelope.isActive())
+      return voice;
+    if (oldest == nullptr || voice->startedAt < oldest->startedAt)
+      oldest = voice;
+    if (!voice->held && (oldestReleased == nullptr
+                         || voice->startedAt < oldestReleased->startedAt))
+      oldestReleased = voice;
+  }
+
+  ++stolen_;
+  return oldestReleased != nullptr ? oldestReleased : oldest;
+}
+
+int VoicePool::getNumActiveVoices() const noexcept
+{
+  int active = 0;
+  for (auto* voice : voices_)
+    active += voice->envelope.isActive() ? 1 : 0;
+  return active;
+}
+
+void VoicePool::prepareToPlay(int samplesPerBlockExpected, double sampleRate)
+{
+  scratchSize_ = juce::jmax(samplesPerBlockExpected, 64);
+  scratch_.allocate((size_t) scratchSize_, true);
+  for (auto* voice : voices_)
+  {
+    voice->osc.prepareToPlay(samplesPerBlockExpected, sampleRate);
+    voice->envelope.setSampleRate(sampleRate);
+    voice->envelope.reset();
+    voice->held = false;
+  }
+}
+
+void VoicePool::releaseResources()
+{
+  scratch_.free();
+  scratchSize_ = 0;
+}
+
+void VoicePool::getNextAudioBlock(const juce::AudioSourceChannelInfo &bufferToFill)
+{
+  auto* mix = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+  renderNextBlock(mix, bufferToFill.numSamples);
+  for (int chan_idx = 1; chan_idx < bufferToFill.buffer->getNumChannels(); ++chan_idx)
+    bufferToFill.buffer->copyFrom(chan_idx, bufferToFill.startSample,
+                                  mix, bufferToFill.numSamples);
+}
+
+void VoicePool::renderNextBlock(float* mix, int numSamples) noexcept
+{
+  juce::FloatVectorOperations::clear(mix, numSamples);
+  if (scratchSize_ == 0)
+    return; // not prepared
+
+  // a host may hand us more than it said it would, take it a scratch at a time
+  for (int offset = 0; offset < numSamples; offset += scratchSize_)
+  {
+    const int count = juce::jmin(scratchSize_, numSamples - offset);
+    for (auto* voice : voices_)
+    {
+      if (!voice->envelope.isActive())
+        continue;
+
+      voice->osc.renderNextBlock(scratch_, count);
+      for (int idx = 0; idx < count; ++idx)
+        mix[offset + idx] += scratch_[idx] * voice->envelope.getNextSample();
+    }
+  }
+}
+
+} // namespace BioSignals
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    VoicePool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableOsc.h"
+
+namespace BioSignals
+{
+
+/**
+ A fixed set of wavetable voices, each with its own envelope, mixed down to
+ one signal.
+
+ Every voice plays the same WavetableBank, which is shared and never written to.
+ All of them are made up front and prepareToPlay() sizes the scratch space,
+ so noteOn(), noteOff() and rendering never touch the heap and are safe to
+ call from the audio thread.
+
+ When every voice is busy, noteOn() steals one: the oldest of those already
+ released, or failing that the oldest of all. The stolen voice's envelope
+ attacks again from wherever it was, so the level doesn't jump.
+ */
+class VoicePool : public juce::AudioSource
+{
+public:
+  static constexpr int defaultNumVoices = 64;
+
+  VoicePool(const WavetableBank& bank, int numVoices = defaultNumVoices);
+  ~VoicePool() override = default;
+
+  /** Before prepareToPlay(), or from the audio thread */
+  void setEnvelope(const juce::ADSR::Parameters& parameters) noexcept;
+
+  /**
+   Starts a note and returns an id for it to be stopped by. velocity scales
+   the voice's amplitude
+   */
+  int noteOn(float frequency, float velocity = 1.0f) noexcept;
+
+  /** Lets the note's envelope release. Does nothing if it was stolen meanwhile */
+  void noteOff(int noteId) noexcept;
+
+  void allNotesOff() noexcept;
+
+  /**
+   The velocity that keeps notes started every noteIntervalSeconds, each
+   released as the next one starts, from summing to more than one of them.
+   The held note is joined by the tails of the ones before it, each falling
+   from at most full level to nothing over the release time, so the gain is
+   1 until the notes come quicker than that
+   */
+  float getOverlapGain(double noteIntervalSeconds) const noexcept;
+
+  int getNumVoices() const noexcept { return voices_.size(); }
+  int getNumActiveVoices() const noexcept;
+  juce::uint64 getStolenCount() const noexcept { return stolen_; }
+
+  virtual void prepareToPlay(
+      int samplesPerBlockExpected, double sampleRate) override;
+
+  virtual void releaseResources() override;
+
+  virtual void getNextAudioBlock(
+      const juce::AudioSourceChannelInfo &bufferToFill) override;
+
+  /** Overwrites mix with the next numSamples of every voice, one channel's worth */
+  void renderNextBlock(float* mix, int numSamples) noexcept;
+
+private:
+  struct Voice
+  {
+    Voice(const WavetableBank& bank) : osc(bank) { }
+
+    WavetableOscillator osc;
+    juce::ADSR envelope;
+    int noteId = 0;
+    juce::uint64 startedAt = 0;
+    bool held = false;
+  };
+
+  Voice* findVoiceToPlay() noexcept;
+
+  juce::OwnedArray<Voice> voices_;
+  juce::ADSR::Parameters envelopeParameters_ { 0.005f, 0.1f, 0.8f, 0.3f };
+  juce::HeapBlock<float> scratch_;
+  int scratchSize_ = 0;
+
+  int lastNoteId_ = 0;
+  juce::uint64 notesStarted_ = 0;
+  juce::uint64 stolen_ = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(VoicePool)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,271 @@
+/*
+  ==============================================================================
+
+    WavetableBank.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetableBank.h"
+
+#include <complex>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/mman.h>
+ #include <unistd.h>
+#endif
+
+namespace BioSignals
+{
+
+namespace
+{
+
+const char bankMagic[4] = { 'B', 'S', 'W', 'T' };
+constexpr juce::uint16 bankVersion = 1;
+constexpr int bankHeaderSize = 32;
+
+using Complex = std::complex<double>;
+
+/**
+ In place radix-2 DFT with e^(+i) twiddles, i.e. an unscaled inverse.
+ twiddles[k] is e^(2 pi i k / size), for k < size / 2
+ */
+void inverseFFT(Complex* data, int size, const Complex* twiddles)
+{
+  for (int idx = 1, reversed = 0; idx < size; ++idx)
+  {
+    int bit = size >> 1;
+    for (; (reversed & bit) != 0; bit >>= 1)
+      reversed ^= bit;
+    reversed |= bit;
+    if (idx < reversed)
+      std::swap(data[idx], data[reversed]);
+  }
+
+  for (int length = 2; length <= size; length <<= 1)
+  {
+    const int half = length >> 1;
+    const int twiddleStep = size / length;
+    for (int start = 0; start < size; start += length)
+    {
+      for (int idx = 0; idx < half; ++idx)
+      {
+        const Complex odd = data[start + idx + half] * twiddles[idx * twiddleStep];
+        data[start + idx + half] = data[start + idx] - odd;
+        data[start + idx] += odd;
+      }
+    }
+  }
+}
+
+} // namespace
+
+WavetableBank::WavetableBank(int tableSize, int maxHarmonics) :
+    tableSize_(tableSize), maxHarmonics_(maxHarmonics)
+{
+  numLevels_ = 0;
+  while ((maxHarmonics_ >> numLevels_) > 0)
+    ++numLevels_;
+  stride_ = tableSize_ + 4; // the guard sample, and keeps every level 16 byte aligned
+}
+
+void WavetableBank::allocate()
+{
+  storage_.allocate((size_t) numLevels_ * (size_t) stride_, true);
+  data_ = storage_;
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createFromHarmonics(
+    const HarmonicFunction& amplitudes, int tableSize, int maxHarmonics)
+{
+  jassert(tableSize >= 4 && (tableSize & (tableSize - 1)) == 0);
+  if (maxHarmonics <= 0)
+    maxHarmonics = tableSize / 4;
+  maxHarmonics = juce::jmin(maxHarmonics, tableSize / 2 - 1);
+
+  std::unique_ptr<WavetableBank> bank(new WavetableBank(tableSize, maxHarmonics));
+  bank->allocate();
+  auto* data = bank->storage_.get();
+
+  // sum of a_n sin(n x) is the imaginary part of the inverse DFT of a_n, so
+  // each level is one FFT instead of tableSize x harmonics calls to sin
+  std::vector<Complex> twiddles((size_t) tableSize / 2);
+  const double angle_delta = juce::MathConstants<double>::twoPi / (double) tableSize;
+  for (int idx = 0; idx < tableSize / 2; ++idx)
+    twiddles[(size_t) idx] = std::polar(1.0, angle_delta * idx);
+
+  std::vector<double> spectrum((size_t) maxHarmonics + 1, 0.0);
+  for (int harmonic = 1; harmonic <= maxHarmonics; ++harmonic)
+    spectrum[(size_t) harmonic] = amplitudes(harmonic);
+
+  std::vector<Complex> bins((size_t) tableSize);
+  for (int level = 0; level < bank->numLevels_; ++level)
+  {
+    std::fill(bins.begin(), bins.end(), Complex());
+    for (int harmonic = 1; harmonic <= bank->getNumHarmonics(level); ++harmonic)
+      bins[(size_t) harmonic] = spectrum[(size_t) harmonic];
+    inverseFFT(bins.data(), tableSize, twiddles.data());
+
+    auto* table = data + (size_t) level * (size_t) bank->stride_;
+    for (int idx = 0; idx < tableSize; ++idx)
+      table[idx] = (float) bins[(size_t) idx].imag();
+    table[tableSize] = table[0];
+  }
+
+  // one gain for every level, the fullest one peaking at 1, so the level
+  // doesn't change with the octave
+  float peak = 0.0f;
+  for (int idx = 0; idx < tableSize; ++idx)
+    peak = juce::jmax(peak, std::abs(data[idx]));
+  if (peak > 0.0f)
+    juce::FloatVectorOperations::multiply(data, 1.0f / peak,
+                                          bank->numLevels_ * bank->stride_);
+
+  return bank;
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createSaw(int tableSize)
+{
+  return createFromHarmonics([] (int harmonic) { return 1.0f / (float) harmonic; },
+                             tableSize);
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createSquare(int tableSize)
+{
+  return createFromHarmonics([] (int harmonic) {
+    return (harmonic & 1) != 0 ? 1.0f / (float) harmonic : 0.0f;
+  }, tableSize);
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createTriangle(int tableSize)
+{
+  return createFromHarmonics([] (int harmonic) {
+    if ((harmonic & 1) == 0)
+      return 0.0f;
+    const float amplitude = 1.0f / (float) (harmonic * harmonic);
+    return (harmonic & 2) != 0 ? -amplitude : amplitude;
+  }, tableSize);
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createForBaked(
+    const juce::uint8* data, size_t numBytes, int& headerSize)
+{
+  if (data == nullptr || numBytes < (size_t) bankHeaderSize
+      || memcmp(data, bankMagic, sizeof(bankMagic)) != 0
+      || juce::ByteOrder::littleEndianShort(data + 4) != bankVersion)
+    return nullptr;
+
+  headerSize = juce::ByteOrder::littleEndianShort(data + 6);
+  const int tableSize = (int) juce::ByteOrder::littleEndianInt(data + 8);
+  const int numLevels = (int) juce::ByteOrder::littleEndianInt(data + 12);
+  const int maxHarmonics = (int) juce::ByteOrder::littleEndianInt(data + 16);
+  const int stride = (int) juce::ByteOrder::littleEndianInt(data + 20);
+  if (headerSize < bankHeaderSize || tableSize < 4 || (tableSize & (tableSize - 1)) != 0
+      || maxHarmonics < 1 || maxHarmonics >= tableSize / 2)
+    return nullptr;
+
+  std::unique_ptr<WavetableBank> bank(new WavetableBank(tableSize, maxHarmonics));
+  const size_t numFloats = (size_t) bank->numLevels_ * (size_t) bank->stride_;
+  if (numLevels != bank->numLevels_ || stride != bank->stride_
+      || numBytes < (size_t) headerSize + numFloats * sizeof(float))
+    return nullptr;
+  return bank;
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createFromMemory(
+    const void* data, size_t numBytes)
+{
+  auto* bytes = static_cast<const juce::uint8*>(data);
+  int headerSize = 0;
+  auto bank = createForBaked(bytes, numBytes, headerSize);
+  if (bank == nullptr)
+    return nullptr;
+
+  bank->allocate();
+  auto* levels = bank->storage_.get();
+  auto* source = bytes + headerSize;
+  const size_t numFloats = (size_t) bank->numLevels_ * (size_t) bank->stride_;
+  for (size_t idx = 0; idx < numFloats; ++idx)
+  {
+    const juce::uint32 bits = juce::ByteOrder::littleEndianInt(source + idx * sizeof(float));
+    memcpy(levels + idx, &bits, sizeof(float));
+  }
+  return bank;
+}
+
+std::unique_ptr<WavetableBank> WavetableBank::createView(
+    std::shared_ptr<const juce::MemoryMappedFile> map, size_t offset, size_t numBytes)
+{
+  auto* bytes = static_cast<const juce::uint8*>(map->getData()) + offset;
+  int headerSize = 0;
+  auto bank = createForBaked(bytes, numBytes, headerSize);
+
+  // the floats are used in place, so they have to be native and aligned
+  auto* levels = bytes + headerSize;
+  if (bank == nullptr || juce::ByteOrder::isBigEndian()
+      || (reinterpret_cast<juce::pointer_sized_uint>(levels) & 15) != 0)
+    return nullptr;
+
+  bank->data_ = reinterpret_cast<const float*>(levels);
+  bank->map_ = std::move(map);
+  return bank;
+}
+
+void WavetableBank::prefault() const noexcept
+{
+  if (map_ == nullptr)
+    return;
+
+  const size_t numFloats = (size_t) numLevels_ * (size_t) stride_;
+  size_t pageSize = 4096;
+#if JUCE_LINUX || JUCE_MAC
+  pageSize = (size_t) sysconf(_SC_PAGESIZE);
+  // one read ahead for the lot rather than a fault a page
+  const auto start = reinterpret_cast<juce::pointer_sized_uint>(data_) & ~(pageSize - 1);
+  const auto end = reinterpret_cast<juce::pointer_sized_uint>(data_ + numFloats);
+  madvise(reinterpret_cast<void*>(start), (size_t) (end - start), MADV_WILLNEED);
+#endif
+
+  volatile float sink = 0.0f;
+  const size_t floatsPerPage = pageSize / sizeof(float);
+  for (size_t idx = 0; idx < numFloats; idx += floatsPerPage)
+    sink = data_[idx];
+  sink = data_[numFloats - 1];
+  juce::ignoreUnused(sink);
+}
+
+bool WavetableBank::writeTo(juce::OutputStream& stream) const
+{
+  bool ok = stream.write(bankMagic, sizeof(bankMagic))
+         && stream.writeShort((short) bankVersion)
+         && stream.writeShort((short) bankHeaderSize)
+         && stream.writeInt(tableSize_)
+         && stream.writeInt(numLevels_)
+         && stream.writeInt(maxHarmonics_)
+         && stream.writeInt(stride_)
+         && stream.writeInt64(0);
+  for (int idx = 0; ok && idx < numLevels_ * stride_; ++idx)
+    ok = stream.writeFloat(data_[idx]);
+  return ok;
+}
+
+size_t WavetableBank::getBakedSize() const noexcept
+{
+  return (size_t) bankHeaderSize + (size_t) numLevels_ * (size_t) stride_ * sizeof(float);
+}
+
+int WavetableBank::getLevelFor(double frequency, double sampleRate) const noexcept
+{
+  // level k has maxHarmonics / 2^k harmonics, and may have as many as fit
+  // under Nyquist: k >= log2(maxHarmonics * frequency / (sampleRate / 2))
+  const double ratio = maxHarmonics_ * 2.0 * frequency / sampleRate;
+  if (!(ratio > 1.0))
+    return 0;
+  int exponent;
+  const double mantissa = std::frexp(ratio, &exponent); // ratio = mantissa * 2^exponent
+  const int level = mantissa == 0.5 ? exponent - 1 : exponent;
+  return juce::jmin(level, numLevels_ - 1);
+}
+
+} // namespace BioSignals
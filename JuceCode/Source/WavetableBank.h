@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    WavetableBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace BioSignals
+{
+
+/**
+ One waveform as a stack of band-limited tables, one per octave.
+
+ Level 0 has the most harmonics, maxHarmonics, and each level after it half
+ as many as the one before, down to a pure sine. An oscillator plays the
+ fullest level whose top harmonic still fits under Nyquist at its
+ frequency, so nothing aliases at the top of the range and the bottom
+ doesn't go dull.
+
+ Every level is tableSize samples plus a guard copy of the first, and they
+ all live back to back in one allocation, getStride() floats apart. The bank
+ is never written to once made, so any number of voices can share it.
+
+ Banks are built with an inverse FFT per level, a few milliseconds for a
+ full 8192 sample one, or copied out of a baked blob (see writeTo()) for no
+ table maths at all:
+
+   header   "BSWT", uint16 version, uint16 header size (32),
+            int32 table size, int32 level count, int32 max harmonics,
+            int32 stride, 8 bytes reserved
+   levels   level count x stride float32, little endian
+
+ A WavetableLibrary holds many of these in one file, and hands out banks
+ that read their levels straight out of its memory map.
+ */
+class WavetableBank
+{
+public:
+  /** Amplitude of harmonic n (1 is the fundamental) */
+  using HarmonicFunction = std::function<float (int harmonic)>;
+
+  /**
+   Sums sines into every level. maxHarmonics defaults to a quarter of
+   tableSize, enough to stay bright down to 12 Hz at 48 kHz.
+   tableSize has to be a power of two.
+   */
+  static std::unique_ptr<WavetableBank> createFromHarmonics(
+      const HarmonicFunction& amplitudes, int tableSize = 8192, int maxHarmonics = 0);
+
+  /** A band-limited sawtooth, 1/n harmonics */
+  static std::unique_ptr<WavetableBank> createSaw(int tableSize = 8192);
+  /** Odd harmonics at 1/n */
+  static std::unique_ptr<WavetableBank> createSquare(int tableSize = 8192);
+  /** Odd harmonics at 1/n^2, alternating in sign */
+  static std::unique_ptr<WavetableBank> createTriangle(int tableSize = 8192);
+
+  /** A copy of a bank baked by writeTo(), e.g. from BinaryData. nullptr if it isn't one */
+  static std::unique_ptr<WavetableBank> createFromMemory(const void* data, size_t numBytes);
+
+  /** Bakes the bank, for createFromMemory() */
+  bool writeTo(juce::OutputStream& stream) const;
+  /** How many bytes writeTo() writes */
+  size_t getBakedSize() const noexcept;
+
+  int getTableSize() const noexcept { return tableSize_; }
+  int getNumLevels() const noexcept { return numLevels_; }
+  int getStride() const noexcept { return stride_; }
+  int getNumHarmonics(int level) const noexcept { return maxHarmonics_ >> level; }
+
+  const float* getTable(int level) const noexcept { return data_ + (size_t) level * (size_t) stride_; }
+
+  /**
+   Reads every page of a bank viewed out of a WavetableLibrary, so its first
+   notes don't fault them in from disk on the audio thread. Call it before
+   handing the bank to anything that plays it. It doesn't pin the pages, the
+   system can still page them out under memory pressure. A bank that owns
+   its levels was written when it was made and has nothing to do
+   */
+  void prefault() const noexcept;
+
+  /** The fullest level that doesn't alias at frequency. O(1) */
+  int getLevelFor(double frequency, double sampleRate) const noexcept;
+
+  const float* getTableFor(double frequency, double sampleRate) const noexcept
+  {
+    return getTable(getLevelFor(frequency, sampleRate));
+  }
+
+private:
+  friend class WavetableLibrary;
+
+  WavetableBank(int tableSize, int maxHarmonics);
+
+  /** An empty bank shaped like the baked one at data, or nullptr if it isn't one */
+  static std::unique_ptr<WavetableBank> createForBaked(const juce::uint8* data,
+                                                       size_t numBytes, int& headerSize);
+  /** A bank whose levels are the ones baked at offset into map */
+  static std::unique_ptr<WavetableBank> createView(
+      std::shared_ptr<const juce::MemoryMappedFile> map, size_t offset, size_t numBytes);
+  void allocate();
+
+  int tableSize_;
+  int maxHarmonics_;
+  int numLevels_;
+  int stride_;
+  juce::HeapBlock<float> storage_;
+  std::shared_ptr<const juce::MemoryMappedFile> map_; // or the levels are in here
+  const float* data_ = nullptr;
+
+  JUCE_DECLARE_NON_COPYABLE(WavetableBank)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    WavetableLibrary.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetableLibrary.h"
+
+namespace BioSignals
+{
+
+namespace
+{
+
+const char libraryMagic[4] = { 'B', 'S', 'W', 'L' };
+
+constexpr juce::uint16 libraryVersion = 1;
+constexpr int libraryHeaderSize = 16;
+constexpr int indexEntrySize = WavetableLibrary::maxNameLength + 16;
+constexpr juce::uint64 bankAlignment = 4096;
+
+inline juce::uint64 alignUp(juce::uint64 offset)
+{
+  return (offset + bankAlignment - 1) & ~(bankAlignment - 1);
+}
+
+} // namespace
+
+//==============================================================================
+bool WavetableLibrary::open(const juce::File& file)
+{
+  map_.reset();
+  index_.clear();
+
+  std::shared_ptr<const juce::MemoryMappedFile> map(
+      new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+  auto* data = static_cast<const juce::uint8*>(map->getData());
+  const size_t size = map->getSize();
+  if (data == nullptr || size < (size_t) libraryHeaderSize
+      || memcmp(data, libraryMagic, sizeof(libraryMagic)) != 0
+      || juce::ByteOrder::littleEndianShort(data + 4) != libraryVersion)
+    return false;
+
+  const size_t headerSize = juce::ByteOrder::littleEndianShort(data + 6);
+  const size_t numBanks = juce::ByteOrder::littleEndianInt(data + 8);
+  if (headerSize < (size_t) libraryHeaderSize || headerSize > size
+      || (size - headerSize) / indexEntrySize < numBanks)
+    return false;
+
+  index_.reserve(numBanks);
+  for (size_t idx = 0; idx < numBanks; ++idx)
+  {
+    auto* entry = data + headerSize + idx * indexEntrySize;
+    auto* name = reinterpret_cast<const char*>(entry);
+    IndexEntry bank;
+    bank.name = juce::String::fromUTF8(name, (int) strnlen(name, maxNameLength));
+    bank.offset = juce::ByteOrder::littleEndianInt64(entry + maxNameLength);
+    bank.size = juce::ByteOrder::littleEndianInt64(entry + maxNameLength + 8);
+    if (bank.offset > size || bank.size > size - bank.offset)
+    {
+      index_.clear();
+      return false;
+    }
+    index_.push_back(bank);
+  }
+
+  map_ = std::move(map);
+  return true;
+}
+
+juce::String WavetableLibrary::getName(int index) const
+{
+  if (index < 0 || index >= getNumBanks())
+    return {};
+  return index_[(size_t) index].name;
+}
+
+int WavetableLibrary::indexOf(const juce::String& name) const
+{
+  for (size_t idx = 0; idx < index_.size(); ++idx)
+    if (index_[idx].name == name)
+      return (int) idx;
+  return -1;
+}
+
+std::unique_ptr<WavetableBank> WavetableLibrary::getBank(int index) const
+{
+  if (map_ == nullptr || index < 0 || index >= getNumBanks())
+    return nullptr;
+  const auto& entry = index_[(size_t) index];
+  return WavetableBank::createView(map_, (size_t) entry.offset, (size_t) entry.size);
+}
+
+std::unique_ptr<WavetableBank> WavetableLibrary::getBank(const juce::String& name) const
+{
+  return getBank(indexOf(name));
+}
+
+bool WavetableLibrary::write(const juce::File& file, const juce::StringArray& names,
+                             const juce::Array<const WavetableBank*>& banks)
+{
+  jassert(names.size() == banks.size());
+
+  file.deleteFile(); // FileOutputStream appends otherwise
+  juce::FileOutputStream stream(file);
+  if (stream.failedToOpen())
+    return false;
+
+  bool ok = stream.write(libraryMagic, sizeof(libraryMagic))
+         && stream.writeShort((short) libraryVersion)
+         && stream.writeShort((short) libraryHeaderSize)
+         && stream.writeInt(banks.size())
+         && stream.writeInt(0);
+
+  juce::uint64 offset = alignUp(libraryHeaderSize + (juce::uint64) banks.size() * indexEntrySize);
+  for (int idx = 0; ok && idx < banks.size(); ++idx)
+  {
+    char name[maxNameLength] = {};
+    names[idx].copyToUTF8(name, maxNameLength); // always nul terminated, so 31 bytes at most
+    ok = stream.write(name, sizeof(name))
+      && stream.writeInt64((juce::int64) offset)
+      && stream.writeInt64((juce::int64) banks[idx]->getBakedSize());
+    offset = alignUp(offset + banks[idx]->getBakedSize());
+  }
+
+  for (int idx = 0; ok && idx < banks.size(); ++idx)
+  {
+    const juce::uint64 position = (juce::uint64) stream.getPosition();
+    ok = stream.writeRepeatedByte(0, (size_t) (alignUp(position) - position))
+      && banks[idx]->writeTo(stream);
+  }
+  stream.flush();
+  return ok;
+}
+
+} // namespace BioSignals
@@ -0,0 +1,78 @@
+/*
+  ==============================================================================
+
+    WavetableLibrary.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WavetableBank.h"
+
+namespace BioSignals
+{
+
+/*
+ Wavetable libraries (.bswl): any number of named single-cycle waves, each
+ with all its octave levels baked, in one file that's opened with a
+ read-only memory map.
+
+   header   "BSWL", uint16 version, uint16 header size (16),
+            uint32 bank count, 4 bytes reserved
+   index    bank count x { char name[32], nul padded,
+                           uint64 file offset, uint64 size }
+   banks    each a .bswt as WavetableBank::writeTo() writes it, starting
+            on a page boundary
+
+ All integers and samples are little endian. Opening only reads the header
+ and index; a bank's levels are paged in when they're first read, by
+ WavetableBank::prefault() or else by whoever plays them, and the pages are
+ shared with every other process that maps the same file.
+ */
+
+//==============================================================================
+/** Opens a .bswl and hands out banks that play straight from the mapping */
+class WavetableLibrary
+{
+public:
+  static constexpr int maxNameLength = 32;
+
+  WavetableLibrary() = default;
+
+  bool open(const juce::File& file);
+  bool isOpen() const noexcept { return map_ != nullptr; }
+
+  int getNumBanks() const noexcept { return (int) index_.size(); }
+  /** Empty if there's no bank at index */
+  juce::String getName(int index) const;
+  /** -1 if there's no bank by that name */
+  int indexOf(const juce::String& name) const;
+
+  /**
+   The bank at index, reading its levels out of the mapped file. It keeps the
+   mapping alive, so it can outlive the library. nullptr if it's damaged
+   */
+  std::unique_ptr<WavetableBank> getBank(int index) const;
+  std::unique_ptr<WavetableBank> getBank(const juce::String& name) const;
+
+  /** Writes banks out as a library, names[i] naming banks[i] */
+  static bool write(const juce::File& file, const juce::StringArray& names,
+                    const juce::Array<const WavetableBank*>& banks);
+
+private:
+  struct IndexEntry
+  {
+    juce::String name;
+    juce::uint64 offset;
+    juce::uint64 size;
+  };
+
+  std::shared_ptr<const juce::MemoryMappedFile> map_;
+  std::vector<IndexEntry> index_;
+
+  JUCE_DECLARE_NON_COPYABLE(WavetableLibrary)
+};
+
+} // namespace BioSignals
@@ -10,13 +10,157 @@
 
 #include "WavetableOsc.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+ #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+#endif
+
 namespace BioSignals
 {
 
+namespace WavetableKernel
+{
+
+void renderScalar(const float* table, int tableSize, juce::uint32& phase,
+                  juce::uint32 increment, float amp,
+                  float* dest, int numSamples) noexcept
+{
+  juce::uint32 current = phase;
+  for (int idx = 0; idx < numSamples; ++idx)
+  {
+    // the phase times the table size: the index on top, the fraction below
+    const juce::uint64 position = (juce::uint64) current * (juce::uint64) tableSize;
+    const auto index = (juce::uint32) (position >> 32);
+    const float frac = (float) (juce::uint32) position * (1.0f / 4294967296.0f);
+    const float value0 = table[index];
+    const float value1 = table[index + 1];
+    dest[idx] = amp * (value0 + frac * (value1 - value0));
+    current += increment;
+  }
+  phase = current;
+}
+
+void renderVector(const float* table, int tableBits, juce::uint32& phase,
+                  juce::uint32 increment, float amp,
+                  float* dest, int numSamples) noexcept
+{
+  const int shift = 32 - tableBits;
+  const juce::uint32 fracMask = (juce::uint32) ((1ull << shift) - 1);
+  const float fracScale = 1.0f / (float) (1ull << shift);
+  int idx = 0;
+
+#if defined(__AVX2__)
+  // gathers do the table lookups too
+  const __m256i count = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i phases = _mm256_add_epi32(
+      _mm256_set1_epi32((int) phase),
+      _mm256_mullo_epi32(count, _mm256_set1_epi32((int) increment)));
+  const __m256i step = _mm256_set1_epi32((int) (increment * 8));
+  const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+  const __m256i mask = _mm256_set1_epi32((int) fracMask);
+  const __m256 scale = _mm256_set1_ps(fracScale);
+  const __m256 gain = _mm256_set1_ps(amp);
+  for (; idx + 8 <= numSamples; idx += 8)
+  {
+    const __m256i index = _mm256_srl_epi32(phases, shiftCount);
+    const __m256 frac = _mm256_mul_ps(
+        _mm256_cvtepi32_ps(_mm256_and_si256(phases, mask)), scale);
+    const __m256 value0 = _mm256_i32gather_ps(table, index, 4);
+    const __m256 value1 = _mm256_i32gather_ps(table + 1, index, 4);
+    const __m256 value = _mm256_add_ps(value0, _mm256_mul_ps(frac, _mm256_sub_ps(value1, value0)));
+    _mm256_storeu_ps(dest + idx, _mm256_mul_ps(gain, value));
+    phases = _mm256_add_epi32(phases, step);
+  }
+#elif defined(__SSE2__) || defined(_M_X64)
+  // no gathers, so the lookups are scalar and the arithmetic around them isn't
+  __m128i phases = _mm_add_epi32(
+      _mm_set1_epi32((int) phase),
+      _mm_setr_epi32(0, (int) increment, (int) (increment * 2), (int) (increment * 3)));
+  const __m128i step = _mm_set1_epi32((int) (increment * 4));
+  const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+  const __m128i mask = _mm_set1_epi32((int) fracMask);
+  const __m128 scale = _mm_set1_ps(fracScale);
+  const __m128 gain = _mm_set1_ps(amp);
+  alignas(16) juce::int32 index[4];
+  for (; idx + 4 <= numSamples; idx += 4)
+  {
+    _mm_store_si128((__m128i*) index, _mm_srl_epi32(phases, shiftCount));
+    const __m128 frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phases, mask)), scale);
+    const __m128 value0 = _mm_setr_ps(table[index[0]], table[index[1]],
+                                      table[index[2]], table[index[3]]);
+    const __m128 value1 = _mm_setr_ps(table[index[0] + 1], table[index[1] + 1],
+                                      table[index[2] + 1], table[index[3] + 1]);
+    const __m128 value = _mm_add_ps(value0, _mm_mul_ps(frac, _mm_sub_ps(value1, value0)));
+    _mm_storeu_ps(dest + idx, _mm_mul_ps(gain, value));
+    phases = _mm_add_epi32(phases, step);
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const juce::uint32 offsets[4] = { 0, increment, increment * 2, increment * 3 };
+  uint32x4_t phases = vaddq_u32(vdupq_n_u32(phase), vld1q_u32(offsets));
+  const uint32x4_t step = vdupq_n_u32(increment * 4);
+  const int32x4_t shiftCount = vdupq_n_s32(-shift);
+  const uint32x4_t mask = vdupq_n_u32(fracMask);
+  const float32x4_t gain = vdupq_n_f32(amp);
+  juce::uint32 index[4];
+  for (; idx + 4 <= numSamples; idx += 4)
+  {
+    vst1q_u32(index, vshlq_u32(phases, shiftCount));
+    const float32x4_t frac = vmulq_n_f32(vcvtq_f32_u32(vandq_u32(phases, mask)), fracScale);
+    const float values0[4] = { table[index[0]], table[index[1]],
+                               table[index[2]], table[index[3]] };
+    const float values1[4] = { table[index[0] + 1], table[index[1] + 1],
+                               table[index[2] + 1], table[index[3] + 1] };
+    const float32x4_t value0 = vld1q_f32(values0);
+    const float32x4_t value = vaddq_f32(value0, vmulq_f32(frac, vsubq_f32(vld1q_f32(values1), value0)));
+    vst1q_f32(dest + idx, vmulq_f32(gain, value));
+    phases = vaddq_u32(phases, step);
+  }
+#endif
+
+  phase += increment * (juce::uint32) idx;
+  renderScalar(table, 1 << tableBits, phase, increment, amp, dest + idx, numSamples - idx);
+}
+
+const char* getVectorName() noexcept
+{
+#if defined(__AVX2__)
+  return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+  return "SSE2";
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+} // namespace WavetableKernel
+
+/** log2 of size if it's a power of two, else -1 */
+static int powerOfTwoBits(int size)
+{
+  if (size <= 0 || (size & (size - 1)) != 0)
+    return -1;
+  int bits = 0;
+  while ((1 << bits) < size)
+    ++bits;
+  return bits;
+}
+
+/** A frequency as the fraction of a cycle to move per sample, see WavetableKernel */
+static juce::uint32 phaseIncrementFor(float frequency, double sampleRate)
+{
+  return (juce::uint32) juce::jlimit(0.0, 4294967295.0,
+                                     std::round(frequency / sampleRate * 4294967296.0));
+}
+
 WavetableOscillator::WavetableOscillator (
-    const juce::AudioSampleBuffer& wavetableToUse)
-        : wavetable (wavetableToUse),
-          tableSize (wavetable.getNumSamples() - 1)
+    const WavetableBank& bankToUse)
+        : bank_ (bankToUse),
+          table_ (bank_.getTable(0)),
+          tableSize (bank_.getTableSize()),
+          tableBits_ (powerOfTwoBits(tableSize))
 {
 //  juce::Logger::getCurrentLogger()->writeToLog("Num samples: " + std::to_string(tableSize));
 }
@@ -31,8 +175,14 @@ void WavetableOscillator::setFrequency(float frequency)
 {
 //  juce::Logger::getCurrentLogger()->writeToLog("Freq: " + std::to_string(frequency));
   frequency_ = frequency;
-  float tableSizeOverSampleRate = (float) tableSize / sampleRate_;
-  tableDelta = frequency_ * tableSizeOverSampleRate;
+  phaseIncrement_ = phaseIncrementFor(frequency_, sampleRate_);
+  selectTable();
+}
+
+void WavetableOscillator::selectTable() noexcept
+{
+  // only ever changes between notes, so switching levels outright is fine
+  table_ = bank_.getTableFor(frequency_, sampleRate_);
 }
 
 void WavetableOscillator::prepareToPlay(
@@ -40,28 +190,22 @@ void WavetableOscillator::prepareToPlay(
 {
   (void) samplesPerBlockExpected; // into the abyss...
   sampleRate_ = sampleRate;
-  juce::Logger::getCurrentLogger()->writeToLog("Sample rate: " + std::to_string(sampleRate));
-  float tableSizeOverSampleRate = (float) tableSize / sampleRate;
-  tableDelta = frequency_ * tableSizeOverSampleRate;
-  juce::Logger::getCurrentLogger()->writeToLog("tableDelta: " + std::to_string(tableDelta));
+  phaseIncrement_ = phaseIncrementFor(frequency_, sampleRate_);
+  selectTable();
 }
 
 void WavetableOscillator::getNextAudioBlock(
     const juce::AudioSourceChannelInfo &bufferToFill)
 {
   bufferToFill.clearActiveBufferRegion();
-  auto* buf0 = bufferToFill.buffer->getWritePointer(0);
-  
-  for (unsigned int idx = 0; idx < bufferToFill.numSamples; ++idx)
-  {
-    buf0[idx] = amp_ * getNextSample();
-  }
+  auto* buf0 = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
+  renderNextBlock(buf0, bufferToFill.numSamples);
   
   for (unsigned int chan_idx = 1;
        chan_idx < bufferToFill.buffer->getNumChannels();
        ++chan_idx)
   {
-    auto* buf = bufferToFill.buffer->getWritePointer(chan_idx);
+    auto* buf = bufferToFill.buffer->getWritePointer(chan_idx, bufferToFill.startSample);
     for (unsigned int idx = 0; idx < bufferToFill.numSamples; ++idx)
     {
       buf[idx] = buf0[idx];
@@ -69,6 +213,16 @@ void WavetableOscillator::getNextAudioBlock(
   }
 }
 
+void WavetableOscillator::renderNextBlock(float* dest, int numSamples) noexcept
+{
+  if (tableBits_ > 0)
+    WavetableKernel::renderVector(table_, tableBits_, phase_, phaseIncrement_, amp_,
+                                  dest, numSamples);
+  else
+    WavetableKernel::renderScalar(table_, tableSize, phase_, phaseIncrement_, amp_,
+                                  dest, numSamples);
+}
+
 std::unique_ptr<juce::AudioSampleBuffer> WavetableOscillator::createWavetableBLITSaw(
     unsigned int table_size, unsigned int num_harmonics)
 {
@@ -81,22 +235,30 @@ std::unique_ptr<juce::AudioSampleBuffer> WavetableOscillator::createWavetableBLI
   auto* samples = wavetable->getWritePointer(0);
   double angle_delta = juce::MathConstants<double>::twoPi /
                            (double) (table_size - 1);
-  
-  auto saw_fn = [&angle_delta, &num_harmonics] (unsigned int table_idx) {
-    float curr_sample = 0.0f;
-    for (unsigned int harm_idx = 0; harm_idx < num_harmonics; ++harm_idx)
+
+  // each harmonic is a phasor turned by a fixed angle per sample, so the
+  // only calls to sin are two per harmonic
+  std::vector<double> sum(table_size, 0.0);
+  for (unsigned int harm_idx = 1; harm_idx <= num_harmonics; ++harm_idx)
+  {
+    const double step_cos = std::cos(angle_delta * harm_idx);
+    const double step_sin = std::sin(angle_delta * harm_idx);
+    const double amplitude = 1.0 / harm_idx;
+    double re = 1.0, im = 0.0;
+    for (unsigned int table_idx = 0; table_idx < table_size; ++table_idx)
     {
-      curr_sample += ((1.0f / ((float) harm_idx + 1.0f)) *
-                      std::sin(angle_delta * (harm_idx + 1) * table_idx));
+      sum[table_idx] += amplitude * im;
+      const double next_re = re * step_cos - im * step_sin;
+      im = re * step_sin + im * step_cos;
+      re = next_re;
     }
-    return curr_sample;
-  };
+  }
 
-  float min = samples[0] = saw_fn(0);
+  float min = samples[0] = (float) sum[0];
   float max = min;
   for (unsigned int table_idx = 1; table_idx < table_size; ++table_idx)
   {
-    float curr_sample = saw_fn(table_idx);
+    float curr_sample = (float) sum[table_idx];
     samples[table_idx] = curr_sample;
 
     max = curr_sample > max ? curr_sample : max;
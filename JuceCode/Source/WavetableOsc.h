@@ -11,17 +11,47 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "WavetableBank.h"
 
 namespace BioSignals
 {
 
 /**
- From the juce tutorial
+ The block render loops behind WavetableOscillator::renderNextBlock(), out
+ here so they can be benchmarked against each other.
+
+ The phase is a fraction of a cycle in 32 bit fixed point, so it wraps by
+ itself and never drifts, however long a note plays. table holds one cycle of
+ tableSize samples plus a copy of the first one at the end.
+ */
+namespace WavetableKernel
+{
+  /** Any table size, one sample at a time */
+  void renderScalar(const float* table, int tableSize, juce::uint32& phase,
+                    juce::uint32 increment, float amp,
+                    float* dest, int numSamples) noexcept;
+
+  /**
+   4 or 8 samples at a time with SSE2, AVX2 or NEON, for tables of
+   1 << tableBits samples. Matches renderScalar() to within float rounding.
+   Falls back on renderScalar() when built without any of them.
+   */
+  void renderVector(const float* table, int tableBits, juce::uint32& phase,
+                    juce::uint32 increment, float amp,
+                    float* dest, int numSamples) noexcept;
+
+  /** Which instruction set renderVector() was built for, or "scalar" */
+  const char* getVectorName() noexcept;
+}
+
+/**
+ From the juce tutorial. Plays whichever level of its WavetableBank suits the
+ frequency, so it stays band-limited all the way up.
  */
 class WavetableOscillator : public juce::ToneGeneratorAudioSource
 {
 public:
-  WavetableOscillator (const juce::AudioSampleBuffer& wavetableToUse);
+  WavetableOscillator (const WavetableBank& bankToUse);
   
   void setAmplitude(float amp);
 
@@ -34,40 +64,24 @@ public:
 
   virtual void getNextAudioBlock(
       const juce::AudioSourceChannelInfo &bufferToFill) override;
+
+  /** Writes the next numSamples of the oscillator to dest, one channel's worth */
+  void renderNextBlock(float* dest, int numSamples) noexcept;
   
   static std::unique_ptr<juce::AudioSampleBuffer> createWavetableBLITSaw(
       unsigned int table_size, unsigned int num_harmonics);
 
-//  static WavetableOscillator& loadFromFile(const std::ifstream& input_file)
-//  {
-//
-//  }
 private:
-  forcedinline float getNextSample() noexcept
-  {
-      auto index0 = (unsigned int) currentIndex;
-      auto index1 = index0 + 1;
-
-      auto frac = currentIndex - (float) index0;
-
-      auto* table = wavetable.getReadPointer (0);
-      auto value0 = table[index0];
-      auto value1 = table[index1];
-
-      auto currentSample = value0 + frac * (value1 - value0);
-
-      if ((currentIndex += tableDelta) > (float) tableSize)
-          currentIndex -= (float) tableSize;
-
-      return currentSample;
-  }
+  void selectTable() noexcept;
 
-  const juce::AudioSampleBuffer& wavetable;
+  const WavetableBank& bank_;
+  const float* table_;  // the level for frequency_, picked by selectTable()
   const int tableSize;
+  const int tableBits_; // log2 of tableSize, or -1 if it isn't a power of two
   double sampleRate_ = 48000.0;
   float amp_ = 0.5f;
   float frequency_ = 440.0f;
-  float currentIndex = 0.0f, tableDelta = 0.0f;
+  juce::uint32 phase_ = 0, phaseIncrement_ = 0; // see WavetableKernel
 };
 
 } // namespace BioSignals
@@ -0,0 +1,664 @@
+/*
+  ==============================================================================
+
+    Benchmarks.cpp
+
+  ==============================================================================
+*/
+
+#include "Benchmarks.h"
+#include "../../Source/WavetableOsc.h"
+#include "../../Source/WavetableLibrary.h"
+#include "../../Source/StereoFilter.h"
+#include "../../Source/Sequencer.h"
+#include "../../Source/SensorDecoder.h"
+
+#include <map>
+#include <stdio.h>
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+namespace BioSignals
+{
+
+/** What WavetableOscillator::getNextSample() used to do, a sample at a time */
+struct LegacyOscillator
+{
+  float currentIndex = 0.0f;
+  float tableDelta = 0.0f;
+
+  void render(const float* table, int tableSize, float amp, float* dest, int numSamples)
+  {
+    for (int idx = 0; idx < numSamples; ++idx)
+    {
+      auto index0 = (unsigned int) currentIndex;
+      auto frac = currentIndex - (float) index0;
+      auto value0 = table[index0];
+      auto value1 = table[index0 + 1];
+      dest[idx] = amp * (value0 + frac * (value1 - value0));
+      if ((currentIndex += tableDelta) > (float) tableSize)
+        currentIndex -= (float) tableSize;
+    }
+  }
+};
+
+static double secondsSince(juce::int64 start)
+{
+  return juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - start);
+}
+
+bool OscillatorBenchmark::run() const
+{
+  constexpr int tableBits = 13;
+  constexpr int tableSize = 1 << tableBits;
+  auto wavetable = WavetableOscillator::createWavetableBLITSaw(tableSize, 27);
+  const float* table = wavetable->getReadPointer(0);
+
+  const int numBlocks = (int) (seconds * sampleRate / blockSize);
+  const double samples = (double) numBlocks * blockSize * numVoices;
+  std::vector<double> frequencies;
+  std::vector<juce::uint32> increments;
+  for (int voice = 0; voice < numVoices; ++voice)
+  {
+    frequencies.push_back(55.0 * std::pow(2.0, voice * 5.0 / numVoices) + voice * 0.37);
+    increments.push_back((juce::uint32) std::round(frequencies.back() / sampleRate * 4294967296.0));
+  }
+
+  juce::HeapBlock<float> scalarOut((size_t) blockSize), vectorOut((size_t) blockSize);
+  std::vector<LegacyOscillator> legacy((size_t) numVoices);
+  std::vector<juce::uint32> scalarPhases((size_t) numVoices, 0), vectorPhases((size_t) numVoices, 0);
+  for (int voice = 0; voice < numVoices; ++voice)
+    legacy[(size_t) voice].tableDelta = (float) (frequencies[(size_t) voice] * tableSize / sampleRate);
+
+  printf("%d voices, %d sample blocks, %.0f s of audio each, vector path: %s\n",
+         numVoices, blockSize, seconds, WavetableKernel::getVectorName());
+
+  auto start = juce::Time::getHighResolutionTicks();
+  for (int block = 0; block < numBlocks; ++block)
+    for (auto& osc : legacy)
+      osc.render(table, tableSize, 0.5f, scalarOut, blockSize);
+  const double legacySeconds = secondsSince(start);
+
+  start = juce::Time::getHighResolutionTicks();
+  for (int block = 0; block < numBlocks; ++block)
+    for (int voice = 0; voice < numVoices; ++voice)
+      WavetableKernel::renderScalar(table, tableSize, scalarPhases[(size_t) voice],
+                                    increments[(size_t) voice], 0.5f, scalarOut, blockSize);
+  const double scalarSeconds = secondsSince(start);
+
+  start = juce::Time::getHighResolutionTicks();
+  for (int block = 0; block < numBlocks; ++block)
+    for (int voice = 0; voice < numVoices; ++voice)
+      WavetableKernel::renderVector(table, tableBits, vectorPhases[(size_t) voice],
+                                    increments[(size_t) voice], 0.5f, vectorOut, blockSize);
+  const double vectorSeconds = secondsSince(start);
+
+  printf("  per sample loop  %7.3f ns/sample\n", 1.0e9 * legacySeconds / samples);
+  printf("  scalar kernel    %7.3f ns/sample\n", 1.0e9 * scalarSeconds / samples);
+  printf("  vector kernel    %7.3f ns/sample  (%.1fx the per sample loop)\n",
+         1.0e9 * vectorSeconds / samples, legacySeconds / vectorSeconds);
+
+  // same again, block for block, comparing as we go
+  double maxDifference = 0.0;
+  bool phasesAgree = true;
+  std::fill(scalarPhases.begin(), scalarPhases.end(), 0u);
+  std::fill(vectorPhases.begin(), vectorPhases.end(), 0u);
+  for (int block = 0; block < numBlocks; ++block)
+  {
+    for (int voice = 0; voice < numVoices; ++voice)
+    {
+      WavetableKernel::renderScalar(table, tableSize, scalarPhases[(size_t) voice],
+                                    increments[(size_t) voice], 0.5f, scalarOut, blockSize);
+      WavetableKernel::renderVector(table, tableBits, vectorPhases[(size_t) voice],
+                                    increments[(size_t) voice], 0.5f, vectorOut, blockSize);
+      for (int idx = 0; idx < blockSize; ++idx)
+        maxDifference = juce::jmax(maxDifference, (double) std::abs(scalarOut[idx] - vectorOut[idx]));
+      phasesAgree = phasesAgree && scalarPhases[(size_t) voice] == vectorPhases[(size_t) voice];
+    }
+  }
+
+  // where the float index ended up against where it should be
+  double maxDrift = 0.0;
+  for (int voice = 0; voice < numVoices; ++voice)
+  {
+    const double exact = std::fmod(frequencies[(size_t) voice] * tableSize / sampleRate
+                                       * (double) numBlocks * blockSize, (double) tableSize);
+    double drift = std::abs(legacy[(size_t) voice].currentIndex - exact);
+    drift = juce::jmin(drift, tableSize - drift);
+    maxDrift = juce::jmax(maxDrift, drift);
+  }
+
+  printf("  vector vs scalar: max difference %.3g, phases %s\n",
+         maxDifference, phasesAgree ? "identical" : "DIFFER");
+  printf("  per sample loop drifted up to %.1f table samples from the true phase\n", maxDrift);
+
+  return phasesAgree && maxDifference <= tolerance;
+}
+
+/** Reads a sample of the level a voice at 440 Hz would play, so it's paged in */
+static float touchBank(const WavetableBank& bank)
+{
+  return bank.getTableFor(440.0, 48000.0)[bank.getTableSize() / 3];
+}
+
+/** Evicts file's pages, so the next read of it comes from the disk. Nothing may have it mapped */
+static bool dropFromPageCache(const juce::File& file)
+{
+#if JUCE_LINUX
+  const int fd = ::open(file.getFullPathName().toRawUTF8(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  // dirty pages stay put, write them back first
+  const bool dropped = fdatasync(fd) == 0
+                    && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  ::close(fd);
+  return dropped;
+#else
+  juce::ignoreUnused(file);
+  return false;
+#endif
+}
+
+/** Opens library, views bankName in it and faults the whole bank in */
+static bool mapAndPrefault(const juce::File& library, const juce::String& bankName,
+                           volatile float& sink)
+{
+  WavetableLibrary opened;
+  auto viewed = opened.open(library) ? opened.getBank(bankName) : nullptr;
+  if (viewed == nullptr)
+    return false;
+  viewed->prefault();
+  sink = touchBank(*viewed);
+  return true;
+}
+
+bool WavetableLoadBenchmark::run() const
+{
+  volatile float sink = 0.0f;
+
+  // from disk, before anything here maps the file and keeps its pages in
+  double coldSeconds = 0.0;
+  int coldRuns = 0;
+  for (; coldRuns < repeats && dropFromPageCache(library); ++coldRuns)
+  {
+    const auto start = juce::Time::getHighResolutionTicks();
+    if (!mapAndPrefault(library, bankName, sink))
+      break;
+    coldSeconds += secondsSince(start);
+  }
+
+  WavetableLibrary first;
+  if (!first.open(library) || first.indexOf(bankName) < 0)
+  {
+    printf("no bank called %s in %s\n", bankName.toRawUTF8(),
+           library.getFullPathName().toRawUTF8());
+    return false;
+  }
+  auto mapped = first.getBank(bankName);
+  if (mapped == nullptr)
+    return false;
+  sink = touchBank(*mapped);
+
+  auto start = juce::Time::getHighResolutionTicks();
+  for (int idx = 0; idx < repeats; ++idx)
+  {
+    auto built = WavetableBank::createFromHarmonics(
+        [] (int harmonic) { return 1.0f / (float) harmonic; }, mapped->getTableSize());
+    sink = touchBank(*built);
+  }
+  const double buildSeconds = secondsSince(start) / repeats;
+
+  juce::MemoryOutputStream baked;
+  mapped->writeTo(baked);
+  start = juce::Time::getHighResolutionTicks();
+  for (int idx = 0; idx < repeats; ++idx)
+  {
+    auto copied = WavetableBank::createFromMemory(baked.getData(), baked.getDataSize());
+    sink = touchBank(*copied);
+  }
+  const double copySeconds = secondsSince(start) / repeats;
+
+  start = juce::Time::getHighResolutionTicks();
+  for (int idx = 0; idx < repeats; ++idx)
+  {
+    WavetableLibrary opened;
+    opened.open(library);
+    auto viewed = opened.getBank(bankName);
+    sink = touchBank(*viewed);
+  }
+  const double mapSeconds = secondsSince(start) / repeats;
+
+  start = juce::Time::getHighResolutionTicks();
+  for (int idx = 0; idx < repeats; ++idx)
+    mapAndPrefault(library, bankName, sink);
+  const double prefaultSeconds = secondsSince(start) / repeats;
+  juce::ignoreUnused(sink);
+
+  printf("%s, %d levels of %d samples (%.0f KB)\n", bankName.toRawUTF8(),
+         mapped->getNumLevels(), mapped->getTableSize(),
+         mapped->getBakedSize() / 1024.0);
+  printf("  build (as a 1/n saw)  %9.3f ms\n", 1000.0 * buildSeconds);
+  printf("  copy from baked blob  %9.3f ms\n", 1000.0 * copySeconds);
+  printf("  map from library      %9.3f ms  (one page read)\n", 1000.0 * mapSeconds);
+  printf("  map and prefault      %9.3f ms  (from the page cache)\n", 1000.0 * prefaultSeconds);
+  if (coldRuns > 0)
+    printf("  map and prefault      %9.3f ms  (cold, from disk)\n",
+           1000.0 * coldSeconds / coldRuns);
+  else
+    printf("  map and prefault, cold: can't drop the library from the page cache here\n");
+  return true;
+}
+
+bool OutputChainBenchmark::run() const
+{
+  const int numBlocks = (int) (seconds * sampleRate / blockSize);
+  const double samples = (double) numBlocks * blockSize;
+
+  // a block of something to stand in for the voices
+  juce::HeapBlock<float> source((size_t) blockSize);
+  juce::Random random(1);
+  for (int idx = 0; idx < blockSize; ++idx)
+    source[idx] = random.nextFloat() - 0.5f;
+
+  juce::HeapBlock<float> gains((size_t) blockSize), cutoffs((size_t) blockSize);
+  juce::AudioSampleBuffer staged(2, blockSize), fused(2, blockSize);
+  StereoFilter stagedFilter, fusedFilter;
+  stagedFilter.prepare(sampleRate, blockSize);
+  fusedFilter.prepare(sampleRate, blockSize);
+
+  auto fillGlides = [&] (int block) {
+    for (int idx = 0; idx < blockSize; ++idx)
+    {
+      const double t = (double) (block * blockSize + idx) / sampleRate;
+      gains[idx] = (float) (0.5 + 0.4 * std::sin(3.0 * t));
+      cutoffs[idx] = (float) (10.0 + 3.0 * std::sin(0.7 * t));
+    }
+  };
+
+  // an analytical count, not a measurement: each pass is charged every float
+  // of the block buffers it reads and writes, whatever the caches make of it
+  auto pass = [&] (juce::int64& floats, int buffersRead, int buffersWritten) {
+    floats += (juce::int64) (buffersRead + buffersWritten) * blockSize;
+  };
+
+  // what getNextAudioBlock did before: every stage a pass over every channel
+  auto renderStaged = [&] (bool gliding, juce::int64& floats) {
+    auto* left = staged.getWritePointer(0);
+    auto* right = staged.getWritePointer(1);
+    juce::FloatVectorOperations::copy(left, source, blockSize);
+    pass(floats, 1, 1);
+    staged.copyFrom(1, 0, left, blockSize);
+    pass(floats, 1, 1);
+    if (gliding)
+    {
+      juce::FloatVectorOperations::multiply(left, gains, blockSize);
+      pass(floats, 2, 1);
+      juce::FloatVectorOperations::multiply(right, gains, blockSize);
+      pass(floats, 2, 1);
+      stagedFilter.process(left, right, cutoffs.get(), blockSize);
+      pass(floats, 3, 2);
+    }
+    else
+    {
+      juce::FloatVectorOperations::multiply(left, 0.5f, blockSize);
+      pass(floats, 1, 1);
+      juce::FloatVectorOperations::multiply(right, 0.5f, blockSize);
+      pass(floats, 1, 1);
+      stagedFilter.process(left, right, 10.0f, blockSize);
+      pass(floats, 2, 2);
+    }
+  };
+
+  auto renderFused = [&] (bool gliding, juce::int64& floats) {
+    auto* mono = fused.getWritePointer(0);
+    juce::FloatVectorOperations::copy(mono, source, blockSize);
+    pass(floats, 1, 1);
+    fusedFilter.processMono(mono, gliding ? gains.get() : nullptr, 0.5f,
+                            gliding ? cutoffs.get() : nullptr, 10.0f, blockSize);
+    pass(floats, gliding ? 3 : 1, 1);
+    fused.copyFrom(1, 0, mono, blockSize);
+    pass(floats, 1, 1);
+  };
+
+  printf("%d sample blocks, %.0f s of audio per run\n", blockSize, seconds);
+
+  double maxDifference = 0.0;
+  for (int gliding = 0; gliding < 2; ++gliding)
+  {
+    stagedFilter.reset();
+    fusedFilter.reset();
+    // one block of glides, played over and over, so the timing doesn't
+    // include the sin() calls that make them
+    fillGlides(0);
+
+    juce::int64 stagedFloats = 0, fusedFloats = 0;
+    auto start = juce::Time::getHighResolutionTicks();
+    for (int block = 0; block < numBlocks; ++block)
+      renderStaged(gliding != 0, stagedFloats);
+    const double stagedSeconds = secondsSince(start);
+
+    start = juce::Time::getHighResolutionTicks();
+    for (int block = 0; block < numBlocks; ++block)
+      renderFused(gliding != 0, fusedFloats);
+    const double fusedSeconds = secondsSince(start);
+
+    // and once more side by side, with the glides moving, to compare
+    stagedFilter.reset();
+    fusedFilter.reset();
+    juce::int64 uncounted = 0;
+    for (int block = 0; block < 64; ++block)
+    {
+      if (gliding != 0)
+        fillGlides(block);
+      renderStaged(gliding != 0, uncounted);
+      renderFused(gliding != 0, uncounted);
+      for (int chan = 0; chan < 2; ++chan)
+        for (int idx = 0; idx < blockSize; ++idx)
+          maxDifference = juce::jmax(maxDifference, (double) std::abs(
+              staged.getSample(chan, idx) - fused.getSample(chan, idx)));
+    }
+
+    printf("  %s\n", gliding != 0 ? "gliding every sample" : "parameters still");
+    printf("    pass per stage  %7.3f ns/sample  %4.1f floats/sample by count\n",
+           1.0e9 * stagedSeconds / samples, (double) stagedFloats / samples);
+    printf("    fused           %7.3f ns/sample  %4.1f floats/sample by count"
+           "  (%.1fx faster, %.1fx fewer floats)\n",
+           1.0e9 * fusedSeconds / samples, (double) fusedFloats / samples,
+           stagedSeconds / fusedSeconds, (double) stagedFloats / (double) fusedFloats);
+  }
+
+  printf("  fused vs staged: max difference %.3g\n", maxDifference);
+  return maxDifference <= tolerance;
+}
+
+struct BenchmarkResult
+{
+  juce::String name;
+  double nanoseconds;
+  juce::String per; // what the time is per, e.g. "sample"
+};
+
+/**
+ Best of repeats runs of call, in ns per unit of work. Each run makes as
+ many calls as it takes to fill minSeconds, found by doubling on the first
+ */
+static double timeCase(const std::function<void()>& call, double unitsPerCall,
+                       int repeats, double minSeconds)
+{
+  call(); // warm the caches up
+  juce::int64 calls = 1;
+  double best = 0.0;
+  for (int run = 0; run < repeats;)
+  {
+    const auto start = juce::Time::getHighResolutionTicks();
+    for (juce::int64 idx = 0; idx < calls; ++idx)
+      call();
+    const double seconds = secondsSince(start);
+    if (run == 0 && seconds < minSeconds && calls < ((juce::int64) 1 << 40))
+    {
+      calls *= 2;
+      continue;
+    }
+
+    const double nanoseconds = 1.0e9 * seconds / ((double) calls * unitsPerCall);
+    best = run == 0 ? nanoseconds : juce::jmin(best, nanoseconds);
+    ++run;
+  }
+  return best;
+}
+
+/**
+ Hands data to decode a serial read's worth at a time, the way the ports do,
+ and counts the records that come out
+ */
+template <typename Decode>
+static int decodeInReads(const juce::MemoryBlock& data, Decode&& decode)
+{
+  constexpr int readSize = 64;
+  constexpr int maxRecords = 64;
+  SensorRecord records[maxRecords];
+  auto* bytes = static_cast<const char*>(data.getData());
+  const int size = (int) data.getSize();
+  int numRecords = 0;
+  for (int offset = 0; offset < size; offset += readSize)
+  {
+    const int count = juce::jmin(readSize, size - offset);
+    for (int done = 0;;)
+    {
+      auto result = decode(bytes + offset + done, count - done, records, maxRecords);
+      numRecords += result.numRecords;
+      done += result.bytesConsumed;
+      if (result.numRecords < maxRecords && done >= count)
+        break;
+    }
+  }
+  return numRecords;
+}
+
+/** "name,ns,per" lines, as BenchmarkSuite writes them */
+static std::map<juce::String, double> readResults(const juce::File& file)
+{
+  std::map<juce::String, double> times;
+  juce::StringArray lines;
+  file.readLines(lines);
+  for (auto& line : lines)
+  {
+    auto fields = juce::StringArray::fromTokens(line, ",", "");
+    if (fields.size() >= 2 && fields[0] != "name")
+      times[fields[0].trim()] = fields[1].getDoubleValue();
+  }
+  return times;
+}
+
+bool BenchmarkSuite::run() const
+{
+  constexpr double sampleRate = 48000.0;
+  juce::ScopedNoDenormals noDenormals; // as the audio callback runs
+  std::vector<BenchmarkResult> results;
+  volatile float sink = 0.0f;
+
+  auto wants = [this] (const juce::String& name) {
+    return filter.isEmpty() || name.contains(filter);
+  };
+  auto add = [&] (const juce::String& name, const juce::String& per, double unitsPerCall,
+                  const std::function<void()>& call) {
+    const double nanoseconds = timeCase(call, unitsPerCall, repeats, minSeconds);
+    results.push_back({ name, nanoseconds, per });
+    printf("  %-28s %10.3f ns/%s\n", name.toRawUTF8(), nanoseconds, per.toRawUTF8());
+    fflush(stdout);
+  };
+
+  printf("best of %d runs of at least %.0f ms each, vector path: %s\n",
+         repeats, 1000.0 * minSeconds, WavetableKernel::getVectorName());
+  auto bank = WavetableBank::createSaw();
+
+  // from blocks so small the per call overhead shows, to big ones
+  for (int blockSize : { 16, 64, 256, 1024, 4096 })
+  {
+    const juce::String name = "osc/block-" + juce::String(blockSize);
+    if (!wants(name))
+      continue;
+    WavetableOscillator osc(*bank);
+    osc.prepareToPlay(blockSize, sampleRate);
+    osc.setFrequency(440.0f);
+    juce::AudioSampleBuffer buffer(2, blockSize);
+    const juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+    add(name, "sample", blockSize, [&] { osc.getNextAudioBlock(info); });
+  }
+
+  // the bottom and top of the tempo range the synth allows, and a step
+  // every 48 samples, which keeps every voice busy and steals all the time
+  for (int tempo : { 10, 2000, 60000 })
+  {
+    const juce::String name = "sequencer/tempo-" + juce::String(tempo);
+    if (!wants(name))
+      continue;
+    constexpr int blockSize = 256;
+    VoicePool voices(*bank);
+    Sequencer sequencer(voices, new FreqSequence(std::vector<juce::uint8> { 48, 55, 60, 64, 67, 72 }),
+                        (double) tempo);
+    sequencer.prepareToPlay(blockSize, sampleRate);
+    juce::AudioSampleBuffer buffer(2, blockSize);
+    const juce::AudioSourceChannelInfo info(&buffer, 0, blockSize);
+    add(name, "sample", blockSize, [&] { sequencer.getNextAudioBlock(info); });
+  }
+
+  if (wants("wavetable/blit-saw"))
+    add("wavetable/blit-saw", "table", 1.0, [&] {
+      sink = WavetableOscillator::createWavetableBLITSaw(8192, 27)->getSample(0, 100);
+    });
+  if (wants("wavetable/bank-saw"))
+    add("wavetable/bank-saw", "bank", 1.0, [&] {
+      sink = WavetableBank::createSaw()->getTable(0)[100];
+    });
+
+  {
+    constexpr int blockSize = 256;
+    StereoFilter svf;
+    svf.prepare(sampleRate, blockSize);
+    juce::AudioSampleBuffer buffer(2, blockSize);
+    juce::HeapBlock<float> mono((size_t) blockSize), source((size_t) blockSize);
+    juce::HeapBlock<float> gains((size_t) blockSize), cutoffs((size_t) blockSize);
+    juce::Random random(1);
+    for (int idx = 0; idx < blockSize; ++idx)
+    {
+      buffer.setSample(0, idx, random.nextFloat() - 0.5f);
+      buffer.setSample(1, idx, random.nextFloat() - 0.5f);
+      source[idx] = random.nextFloat() - 0.5f;
+      gains[idx] = 0.5f + 0.1f * (float) idx / blockSize;
+      cutoffs[idx] = 8.0f + 4.0f * (float) idx / blockSize;
+    }
+    auto* left = buffer.getWritePointer(0);
+    auto* right = buffer.getWritePointer(1);
+
+    if (wants("filter/stereo-still"))
+      add("filter/stereo-still", "sample", blockSize, [&] {
+        svf.process(left, right, 10.0f, blockSize);
+      });
+    if (wants("filter/stereo-gliding"))
+      add("filter/stereo-gliding", "sample", blockSize, [&] {
+        svf.process(left, right, cutoffs.get(), blockSize);
+      });
+    if (wants("filter/mono-fused-gliding"))
+      add("filter/mono-fused-gliding", "sample", blockSize, [&] {
+        // a fresh mix each time, as the callback gets, or gains of about a
+        // half would take the block down to nothing within a few hundred
+        juce::FloatVectorOperations::copy(mono, source, blockSize);
+        svf.processMono(mono, gains, 0.5f, cutoffs, 10.0f, blockSize);
+      });
+  }
+
+  juce::MemoryBlock text;
+  for (auto& file : corpus)
+  {
+    juce::MemoryBlock capture;
+    if (file.loadFileAsData(capture))
+      text.append(capture.getData(), capture.getSize());
+  }
+  if (text.isEmpty())
+  {
+    printf("  no captures, skipping parse/\n");
+  }
+  else
+  {
+    // the same readings as sensor_frame.h frames, one a frame, as the
+    // simulator's --binary sends them
+    juce::MemoryOutputStream frames;
+    SensorLineParser toFrames;
+    juce::uint32 deviceMs = 0;
+    decodeInReads(text, [&] (const char* data, int numBytes, SensorRecord* out, int maxRecords) {
+      auto result = toFrames.parse(data, numBytes, out, maxRecords);
+      for (int idx = 0; idx < result.numRecords; ++idx)
+      {
+        SensorFrame frame;
+        sensorFrameBegin(&frame, deviceMs += 10);
+        sensorFrameAdd(&frame, out[idx].sensor, out[idx].value);
+        juce::uint8 encoded[SENSOR_FRAME_MAX_ENCODED];
+        frames.write(encoded, sensorFrameEncode(&frame, encoded));
+      }
+      return result;
+    });
+    const juce::MemoryBlock binary(frames.getData(), frames.getDataSize());
+
+    SensorLineParser parser;
+    SensorStreamDecoder lineDecoder, frameDecoder;
+    frameDecoder.setWireFormat(SensorStreamDecoder::BINARY_FRAMES);
+    auto parse = [] (auto& decoder) {
+      return [&decoder] (const char* data, int numBytes, SensorRecord* out, int maxRecords) {
+        return decoder.parse(data, numBytes, out, maxRecords);
+      };
+    };
+    auto decode = [] (auto& decoder) {
+      return [&decoder] (const char* data, int numBytes, SensorRecord* out, int maxRecords) {
+        return decoder.decode(data, numBytes, out, maxRecords);
+      };
+    };
+
+    if (wants("parse/lines"))
+      add("parse/lines", "byte", (double) text.getSize(), [&] {
+        sink = (float) decodeInReads(text, parse(parser));
+      });
+    if (wants("parse/decoder-lines"))
+      add("parse/decoder-lines", "byte", (double) text.getSize(), [&] {
+        sink = (float) decodeInReads(text, decode(lineDecoder));
+      });
+    if (wants("parse/decoder-frames"))
+      add("parse/decoder-frames", "byte", (double) binary.getSize(), [&] {
+        sink = (float) decodeInReads(binary, decode(frameDecoder));
+      });
+  }
+  juce::ignoreUnused(sink);
+
+  bool ok = true;
+  if (output != juce::File())
+  {
+    juce::String csv = "name,ns,per\n";
+    for (auto& result : results)
+      csv << result.name << "," << juce::String(result.nanoseconds, 3) << "," << result.per << "\n";
+    if (!output.replaceWithText(csv))
+    {
+      printf("can't write %s\n", output.getFullPathName().toRawUTF8());
+      ok = false;
+    }
+  }
+
+  if (baseline != juce::File())
+  {
+    const auto before = readResults(baseline);
+    if (before.empty())
+    {
+      printf("no results in %s to compare with\n", baseline.getFullPathName().toRawUTF8());
+      return false;
+    }
+
+    printf("against %s, %.0f%% slower allowed\n",
+           baseline.getFullPathName().toRawUTF8(), 100.0 * tolerance);
+    int regressions = 0;
+    for (auto& result : results)
+    {
+      auto found = before.find(result.name);
+      if (found == before.end() || found->second <= 0.0)
+      {
+        printf("  %-28s %10s -> %10.3f  new\n", result.name.toRawUTF8(), "", result.nanoseconds);
+        continue;
+      }
+      const double change = result.nanoseconds / found->second - 1.0;
+      const bool regressed = change > tolerance;
+      regressions += regressed ? 1 : 0;
+      printf("  %-28s %10.3f -> %10.3f  %+6.1f%%%s\n", result.name.toRawUTF8(),
+             found->second, result.nanoseconds, 100.0 * change, regressed ? "  REGRESSED" : "");
+    }
+    if (regressions > 0)
+    {
+      printf("%d of %d cases regressed\n", regressions, (int) results.size());
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+} // namespace BioSignals
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    Benchmarks.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace BioSignals
+{
+
+/**
+ Times the oscillator's render paths against each other: the per-sample
+ loop WavetableOscillator used to run, WavetableKernel::renderScalar() and
+ WavetableKernel::renderVector(). Also checks the last two agree, and how far
+ the old float phase has drifted by the end.
+
+ Returns false if the vector path disagrees with the scalar one.
+ */
+struct OscillatorBenchmark
+{
+  double seconds = 10.0;      // of audio, per path
+  double sampleRate = 48000.0;
+  int blockSize = 64;
+  int numVoices = 16;         // spread over a few octaves
+  double tolerance = 1.0e-5;  // biggest difference allowed between the paths
+
+  bool run() const;
+};
+
+/**
+ Times the ways the synth can get its wavetables at start up: building a
+ bank, copying one out of a baked blob (as from BinaryData) and opening a
+ .bswl library and viewing a bank in place, through to the first sample
+ read of a level. Each is run repeats times and the mean printed.
+
+ A view only reads the page that sample is on, so the library is also timed
+ with the whole bank prefault()ed, as the app loads it: from the page cache,
+ and cold, with the file dropped from the cache before each run. Dropping it
+ needs posix_fadvise(), so the cold runs are Linux only.
+
+ Returns false if the library can't be opened or doesn't have bankName.
+ */
+struct WavetableLoadBenchmark
+{
+  juce::File library;
+  juce::String bankName = "saw";
+  int repeats = 20;
+
+  bool run() const;
+};
+
+/**
+ Times MainComponent's output chain, from the mono voice mix to a stereo
+ buffer, both ways: a pass per stage (copy the mix to the second channel,
+ gain each channel, filter the pair) against the fused path (gain and filter
+ the mono mix in one pass, then copy it out). Each is timed with the
+ parameters still and with gain and cutoff gliding every sample. Next to
+ the times goes an analytical count of the floats each path reads and
+ writes per sample: every pass is charged the whole of each block buffer it
+ touches. It isn't measured memory traffic, caches and what the filter
+ keeps to itself are left out. It comes to 12 against 6 with the parameters
+ still and 15 against 8 gliding, about half.
+
+ Returns false if the two paths' output differs by more than tolerance.
+ */
+struct OutputChainBenchmark
+{
+  double seconds = 10.0;
+  double sampleRate = 48000.0;
+  int blockSize = 256;
+  double tolerance = 1.0e-4;
+
+  bool run() const;
+};
+
+/**
+ The regression suite: the audio callback's hot paths and the serial
+ parser, each case timed as the best of repeats runs of at least minSeconds
+ and reported per unit of work, so a change that slows one shows up however
+ the others move.
+
+   osc/block-N          WavetableOscillator::getNextAudioBlock(), N samples a call, ns/sample
+   sequencer/tempo-N    Sequencer::getNextAudioBlock() at N steps a minute, from
+                        the bottom of the tempo range to a step every 48 samples, ns/sample
+   wavetable/blit-saw   createWavetableBLITSaw(), ns/table
+   wavetable/bank-saw   WavetableBank::createSaw(), ns/bank
+   filter/...           StereoFilter, still and gliding, and the fused mono pass, ns/sample
+   parse/...            SensorLineParser, and SensorStreamDecoder on lines and on
+                        frames, over the capture corpus, ns/byte
+
+ Results go out as CSV, a "name,ns,unit" line a case, which is also what
+ baseline is read as. A case more than tolerance slower than its baseline
+ fails the run.
+
+ Returns false on a regression, or if output can't be written.
+ */
+struct BenchmarkSuite
+{
+  juce::Array<juce::File> corpus;  // captures for the parse cases, skipped without
+  juce::String filter;             // only run cases whose name contains this
+  int repeats = 5;
+  double minSeconds = 0.05;        // per run
+  juce::File output;               // the CSV to write, if any
+  juce::File baseline;             // and to compare against
+  double tolerance = 0.15;         // slowdown allowed, as a fraction
+
+  bool run() const;
+};
+
+} // namespace BioSignals
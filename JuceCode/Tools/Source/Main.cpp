@@ -0,0 +1,427 @@
+/*
+  ==============================================================================
+
+    Command line tools for working on the synth without the hardware (or the
+    GUI) in the loop.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SensorSimulator.h"
+#include "Benchmarks.h"
+#include "OfflineRenderer.h"
+#include "StressTests.h"
+#include "../../Source/RealtimeGuard.h"
+#include "../../Source/WavetableLibrary.h"
+
+#include <signal.h>
+#include <stdio.h>
+
+static BioSignals::SensorSimulator* running_simulator = nullptr;
+
+static void stopOnSignal(int)
+{
+  if (running_simulator != nullptr)
+    running_simulator->stop();
+}
+
+static double doubleOption(const juce::ArgumentList& args,
+                           const juce::String& option, double fallback)
+{
+  return args.containsOption(option)
+      ? args.getValueForOption(option).getDoubleValue() : fallback;
+}
+
+//==============================================================================
+static void simulate(const juce::ArgumentList& args)
+{
+  BioSignals::SensorSimulator::Options options;
+  options.baudRate = doubleOption(args, "--baud", options.baudRate);
+  options.speed = doubleOption(args, "--speed", options.speed);
+  options.maxThroughput = args.containsOption("--max");
+  options.jitterMs = doubleOption(args, "--jitter-ms", options.jitterMs);
+  options.burstSize = (int) doubleOption(args, "--burst", options.burstSize);
+  options.binaryFrames = args.containsOption("--binary");
+  options.loop = args.containsOption("--loop");
+  options.durationSeconds = doubleOption(args, "--duration", options.durationSeconds);
+  options.seed = (juce::int64) doubleOption(args, "--seed", (double) options.seed);
+  options.linkPath = args.getValueForOption("--link");
+
+  if (options.baudRate <= 0.0 || options.speed <= 0.0)
+    juce::ConsoleApplication::fail("--baud and --speed must be positive");
+
+  BioSignals::SensorSimulator simulator(options);
+  int num_captures = 0;
+  for (int idx = 1; idx < args.size(); ++idx)
+  {
+    if (args[idx].isOption())
+      continue;
+    auto capture = args[idx].resolveAsFile();
+    if (!simulator.addCapture(capture))
+      juce::ConsoleApplication::fail("can't read " + capture.getFullPathName());
+    ++num_captures;
+  }
+  if (num_captures == 0)
+    juce::ConsoleApplication::fail("no capture files given");
+
+  const juce::String slave = simulator.open();
+  if (slave.isEmpty())
+    juce::ConsoleApplication::fail("can't open a pseudo-terminal");
+
+  printf("connect with BIOSIGNALS_SERIAL_PORT=%s BIOSIGNALS_SERIAL_BAUD=%d\n",
+         slave.toRawUTF8(), (int) options.baudRate);
+
+  running_simulator = &simulator;
+  signal(SIGINT, stopOnSignal);
+  signal(SIGTERM, stopOnSignal);
+  simulator.run();
+  running_simulator = nullptr;
+}
+
+//==============================================================================
+static void benchOscillator(const juce::ArgumentList& args)
+{
+  BioSignals::OscillatorBenchmark bench;
+  bench.seconds = doubleOption(args, "--seconds", bench.seconds);
+  bench.blockSize = (int) doubleOption(args, "--block", bench.blockSize);
+  bench.numVoices = (int) doubleOption(args, "--voices", bench.numVoices);
+
+  if (bench.seconds <= 0.0 || bench.blockSize <= 0 || bench.numVoices <= 0)
+    juce::ConsoleApplication::fail("--seconds, --block and --voices must be positive");
+
+  if (!bench.run())
+    juce::ConsoleApplication::fail("the vector and scalar paths disagree");
+}
+
+//==============================================================================
+static void bakeWavetables(const juce::ArgumentList& args)
+{
+  const int tableSize = (int) doubleOption(args, "--size", 8192);
+  if (tableSize < 4 || (tableSize & (tableSize - 1)) != 0)
+    juce::ConsoleApplication::fail("--size must be a power of two");
+
+  juce::File directory = juce::File::getCurrentWorkingDirectory();
+  for (int idx = 1; idx < args.size(); ++idx)
+    if (!args[idx].isOption())
+      directory = args[idx].resolveAsFile();
+  if (!directory.isDirectory())
+    juce::ConsoleApplication::fail(directory.getFullPathName() + " isn't a directory");
+
+  auto start = juce::Time::getHighResolutionTicks();
+  std::unique_ptr<BioSignals::WavetableBank> banks[] = {
+    BioSignals::WavetableBank::createSaw(tableSize),
+    BioSignals::WavetableBank::createSquare(tableSize),
+    BioSignals::WavetableBank::createTriangle(tableSize)
+  };
+  const juce::StringArray names { "saw", "square", "triangle" };
+  const double seconds = juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - start);
+
+  // the app embeds the saw on its own
+  auto file = directory.getChildFile("saw.bswt");
+  file.deleteFile(); // FileOutputStream appends otherwise
+  juce::FileOutputStream stream(file);
+  if (stream.failedToOpen() || !banks[0]->writeTo(stream))
+    juce::ConsoleApplication::fail("can't write " + file.getFullPathName());
+  stream.flush();
+
+  juce::Array<const BioSignals::WavetableBank*> all;
+  for (auto& bank : banks)
+    all.add(bank.get());
+  auto library = directory.getChildFile("standard.bswl");
+  if (!BioSignals::WavetableLibrary::write(library, names, all))
+    juce::ConsoleApplication::fail("can't write " + library.getFullPathName());
+
+  printf("%s and %s: %d banks of %d levels of %d samples, built in %.1f ms\n",
+         file.getFullPathName().toRawUTF8(), library.getFullPathName().toRawUTF8(),
+         names.size(), banks[0]->getNumLevels(), tableSize, 1000.0 * seconds);
+}
+
+/** The arduino_dump_*.data captures, from the first directory up from here that has them */
+static juce::Array<juce::File> findBundledCaptures()
+{
+  for (auto directory = juce::File::getCurrentWorkingDirectory();;
+       directory = directory.getParentDirectory())
+  {
+    auto captures = directory.getChildFile("ArduinoCode/arduino_analog")
+                        .findChildFiles(juce::File::findFiles, false, "arduino_dump_*.data");
+    if (!captures.isEmpty() || directory.isRoot())
+    {
+      captures.sort();
+      return captures;
+    }
+  }
+}
+
+static void bench(const juce::ArgumentList& args)
+{
+  BioSignals::BenchmarkSuite suite;
+  suite.repeats = (int) doubleOption(args, "--repeats", suite.repeats);
+  suite.minSeconds = doubleOption(args, "--min-seconds", suite.minSeconds);
+  suite.tolerance = doubleOption(args, "--tolerance", 100.0 * suite.tolerance) / 100.0;
+  suite.filter = args.getValueForOption("--filter");
+  if (args.containsOption("--csv"))
+    suite.output = juce::File::getCurrentWorkingDirectory().getChildFile(
+        args.getValueForOption("--csv"));
+  if (args.containsOption("--baseline"))
+    suite.baseline = juce::File::getCurrentWorkingDirectory().getChildFile(
+        args.getValueForOption("--baseline"));
+  for (int idx = 1; idx < args.size(); ++idx)
+    if (!args[idx].isOption())
+      suite.corpus.add(args[idx].resolveAsFile());
+  if (suite.corpus.isEmpty())
+    suite.corpus = findBundledCaptures();
+
+  if (suite.repeats <= 0 || suite.minSeconds <= 0.0 || suite.tolerance < 0.0)
+    juce::ConsoleApplication::fail("--repeats and --min-seconds must be positive, "
+                                   "--tolerance can't be negative");
+  if (suite.baseline != juce::File() && !suite.baseline.existsAsFile())
+    juce::ConsoleApplication::fail("no baseline at " + suite.baseline.getFullPathName());
+
+  if (!suite.run())
+    juce::ConsoleApplication::fail("the benchmark suite failed, see above");
+}
+
+static void benchOutputChain(const juce::ArgumentList& args)
+{
+  BioSignals::OutputChainBenchmark bench;
+  bench.seconds = doubleOption(args, "--seconds", bench.seconds);
+  bench.blockSize = (int) doubleOption(args, "--block", bench.blockSize);
+
+  if (bench.seconds <= 0.0 || bench.blockSize <= 0)
+    juce::ConsoleApplication::fail("--seconds and --block must be positive");
+
+  if (!bench.run())
+    juce::ConsoleApplication::fail("the fused output chain doesn't match the staged one");
+}
+
+static void benchWavetables(const juce::ArgumentList& args)
+{
+  BioSignals::WavetableLoadBenchmark bench;
+  bench.repeats = (int) doubleOption(args, "--repeats", bench.repeats);
+  if (args.containsOption("--bank"))
+    bench.bankName = args.getValueForOption("--bank");
+  for (int idx = 1; idx < args.size(); ++idx)
+    if (!args[idx].isOption())
+      bench.library = args[idx].resolveAsFile();
+
+  if (bench.repeats <= 0)
+    juce::ConsoleApplication::fail("--repeats must be positive");
+  if (!bench.library.existsAsFile())
+    juce::ConsoleApplication::fail("no library given, make one with bake-wavetables");
+
+  if (!bench.run())
+    juce::ConsoleApplication::fail("can't load from " + bench.library.getFullPathName());
+}
+
+//==============================================================================
+static void render(const juce::ArgumentList& args)
+{
+  BioSignals::OfflineRenderer::Options options;
+  options.sampleRate = doubleOption(args, "--rate", options.sampleRate);
+  options.blockSize = (int) doubleOption(args, "--block", options.blockSize);
+  options.bitsPerSample = (int) doubleOption(args, "--bits", options.bitsPerSample);
+  options.baudRate = doubleOption(args, "--baud", options.baudRate);
+  options.tailSeconds = doubleOption(args, "--tail", options.tailSeconds);
+  options.durationSeconds = doubleOption(args, "--duration", options.durationSeconds);
+  options.volume = (float) doubleOption(args, "--volume", options.volume);
+  options.randomSequence = !args.containsOption("--in-order");
+  options.seed = (juce::int64) doubleOption(args, "--seed", (double) options.seed);
+  if (args.containsOption("--notes"))
+  {
+    options.notes.clear();
+    for (auto& note : juce::StringArray::fromTokens(args.getValueForOption("--notes"), ",", ""))
+      options.notes.push_back((juce::uint8) juce::jlimit(0, 127, note.getIntValue()));
+  }
+  if (args.containsOption("--wavetables"))
+    options.wavetables = juce::File::getCurrentWorkingDirectory().getChildFile(
+        args.getValueForOption("--wavetables"));
+  if (args.containsOption("--bank"))
+    options.wavetableName = args.getValueForOption("--bank");
+
+  if (options.sampleRate <= 0.0 || options.blockSize <= 0 || options.baudRate <= 0.0)
+    juce::ConsoleApplication::fail("--rate, --block and --baud must be positive");
+
+  juce::Array<juce::File> files;
+  for (int idx = 1; idx < args.size(); ++idx)
+    if (!args[idx].isOption())
+      files.add(args[idx].resolveAsFile());
+  if (files.size() != 2)
+    juce::ConsoleApplication::fail("give a sensor stream to read and a file to write");
+
+  const bool checkRealtime = args.containsOption("--check-realtime");
+  if (checkRealtime && !BioSignals::RealtimeGuard::isAvailable())
+    juce::ConsoleApplication::fail("--check-realtime needs a build with BIOSIGNALS_REALTIME_CHECKS=1, "
+                                   "as the Debug configuration is");
+  BioSignals::RealtimeGuard::setLogging(false); // reported below instead
+  BioSignals::RealtimeGuard::reset();
+
+  BioSignals::OfflineRenderer renderer(options);
+  if (!renderer.open(files[0]) || !renderer.render(files[1]))
+    juce::ConsoleApplication::fail(renderer.getError());
+
+  printf("%s: %.1f s of audio from %llu readings over %.1f s\n",
+         files[1].getFullPathName().toRawUTF8(), renderer.getAudioSeconds(),
+         (unsigned long long) renderer.getNumReadings(), renderer.getStreamSeconds());
+  printf("rendered in %.3f s, %.0fx real time (%.0fx with the encoding, %.3f s)\n",
+         renderer.getRenderSeconds(),
+         renderer.getAudioSeconds() / juce::jmax(renderer.getRenderSeconds(), 1.0e-9),
+         renderer.getAudioSeconds() / juce::jmax(renderer.getElapsedSeconds(), 1.0e-9),
+         renderer.getElapsedSeconds());
+  printf("peak %.1f dBFS%s\n", juce::Decibels::gainToDecibels(renderer.getPeak()),
+         renderer.getPeak() > 1.0f ? ", clipped" : "");
+
+  if (checkRealtime)
+  {
+    const auto violations = BioSignals::RealtimeGuard::getViolations();
+    for (auto& violation : violations)
+      printf("\n%s, %d times, first from:\n%s", violation.what.toRawUTF8(),
+             violation.count, violation.stackTrace.toRawUTF8());
+    if (!violations.empty())
+      juce::ConsoleApplication::fail(juce::String(BioSignals::RealtimeGuard::getNumViolations())
+                                     + " real time violations in the audio callback");
+    printf("no real time violations in the audio callback\n");
+  }
+}
+
+//==============================================================================
+static void stressSequencer(const juce::ArgumentList& args)
+{
+  BioSignals::SequencerStressTest stress;
+  stress.seconds = doubleOption(args, "--seconds", stress.seconds);
+  stress.blockSize = (int) doubleOption(args, "--block", stress.blockSize);
+  stress.editsPerSecond = doubleOption(args, "--edits-per-second", stress.editsPerSecond);
+  stress.seed = (juce::int64) doubleOption(args, "--seed", (double) stress.seed);
+  if (stress.seconds <= 0.0 || stress.blockSize <= 0)
+    juce::ConsoleApplication::fail("--seconds and --block must be positive");
+
+  if (!stress.run())
+    juce::ConsoleApplication::fail("the sequencer lost track of a generator");
+}
+
+//==============================================================================
+static void test(const juce::ArgumentList& args)
+{
+  juce::UnitTestRunner runner;
+  runner.setAssertOnFailure(false);
+  if (args.size() > 1 && !args[1].isOption())
+    runner.runTestsInCategory(args[1].text);
+  else
+    runner.runAllTests();
+
+  int failures = 0;
+  for (int idx = 0; idx < runner.getNumResults(); ++idx)
+    failures += runner.getResult(idx)->failures;
+  if (failures > 0)
+    juce::ConsoleApplication::fail(juce::String(failures) + " test failures");
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+  juce::ConsoleApplication app;
+  app.addHelpCommand("--help|-h", "Usage: BioSignalsTools <command> [options]", true);
+
+  app.addCommand({ "simulate",
+                   "simulate [--baud=N] [--speed=X] [--max] [--jitter-ms=N] [--burst=N] "
+                   "[--binary] [--loop] [--duration=S] [--seed=N] [--link=PATH] capture...",
+                   "Replays sensor captures into a pty, like a board on a serial port",
+                   "Opens a pseudo-terminal and plays the given captures (e.g. "
+                   "ArduinoCode/arduino_dump_*.data) into it, paced as if sent at --baud. "
+                   "--speed plays N times faster, --max as fast as the reader drains, "
+                   "--jitter-ms and --burst roughen up the timing and --binary re-encodes "
+                   "the lines as sensor_frame.h frames. Throughput and the time spent "
+                   "waiting on a full pty are printed once a second.",
+                   simulate });
+
+  app.addCommand({ "bench-osc",
+                   "bench-osc [--seconds=S] [--block=N] [--voices=N]",
+                   "Times the oscillator's render paths against each other",
+                   "Renders S seconds of audio per voice through the old per-sample "
+                   "loop, the scalar kernel and the SIMD kernel, prints ns per sample "
+                   "for each and fails if the SIMD output strays from the scalar one.",
+                   benchOscillator });
+
+  app.addCommand({ "bake-wavetables",
+                   "bake-wavetables [--size=N] [directory]",
+                   "Writes the synth's standard wavetable banks out for embedding",
+                   "Builds the standard WavetableBanks (saw, square, triangle) with "
+                   "tables of N samples and writes them to directory as standard.bswl, "
+                   "a library the app can map with BIOSIGNALS_WAVETABLES, and the saw on "
+                   "its own as saw.bswt. JuceCode/Resources holds the saw.bswt the app "
+                   "embeds as BinaryData when it's built with BIOSIGNALS_BAKED_WAVETABLES.",
+                   bakeWavetables });
+
+  app.addCommand({ "bench-output",
+                   "bench-output [--seconds=S] [--block=N]",
+                   "Times the fused output chain against a pass per stage",
+                   "Puts S seconds of a mono mix through gain, the low pass and the fan "
+                   "out to stereo, once a stage at a time and once fused, with the "
+                   "parameters still and gliding. Prints ns per sample and a count, worked "
+                   "out from the passes each path makes rather than measured, of the floats "
+                   "it moves per sample. Fails if the two outputs differ.",
+                   benchOutputChain });
+
+  app.addCommand({ "bench-wavetables",
+                   "bench-wavetables [--repeats=N] [--bank=NAME] library.bswl",
+                   "Times building a wavetable bank against loading a baked one",
+                   "Builds the bank, copies it from a baked blob and maps it from the "
+                   "library N times each, reading a sample of a level every time, and "
+                   "prints the mean time each takes. The library is also mapped with the "
+                   "whole bank faulted in, as the app loads it, from the page cache and "
+                   "(on Linux) cold, with the file dropped from the cache before each run.",
+                   benchWavetables });
+
+  app.addCommand({ "bench",
+                   "bench [--filter=TEXT] [--repeats=N] [--min-seconds=S] [--csv=PATH] "
+                   "[--baseline=PATH] [--tolerance=PERCENT] [capture...]",
+                   "Runs the performance regression suite",
+                   "Times the oscillator at several block sizes, the sequencer at extreme "
+                   "tempos, wavetable construction, the low pass and the serial parsers, "
+                   "the last over the given captures or else the bundled "
+                   "arduino_dump_*.data. Each case is the best of N runs of at least S "
+                   "seconds, in ns per sample, byte or table. --csv writes the results, "
+                   "and --baseline compares them with an earlier --csv, failing if any "
+                   "case got more than PERCENT (15) slower.",
+                   bench });
+
+  app.addCommand({ "render",
+                   "render [--rate=N] [--block=N] [--bits=N] [--baud=N] [--tail=S] "
+                   "[--duration=S] [--volume=X] [--in-order] [--notes=N,N,...] [--seed=N] "
+                   "[--wavetables=PATH] [--bank=NAME] [--check-realtime] input output",
+                   "Renders a recorded sensor stream to a WAV or FLAC file, offline",
+                   "Plays input, a .bslog session or a raw capture (e.g. "
+                   "ArduinoCode/arduino_dump_*.data, paced as if it came in at --baud), "
+                   "through the synth on a virtual clock, as fast as it'll go, and writes "
+                   "output as a .wav or .flac of --bits. It runs for the stream plus --tail "
+                   "seconds, or for --duration. The sequence is a seeded random walk "
+                   "through --notes (MIDI numbers), or steps through them with --in-order, "
+                   "so the same input and options always give the same file. Prints how "
+                   "many times faster than real time it rendered. --check-realtime fails if "
+                   "the audio callback allocated, locked or made a blocking system call, "
+                   "and prints where from, in builds with BIOSIGNALS_REALTIME_CHECKS. Only "
+                   "Linux builds check all of that; elsewhere, macOS included, it only "
+                   "catches operator new and delete, not locks or system calls.",
+                   render });
+
+  app.addCommand({ "stress-sequencer",
+                   "stress-sequencer [--seconds=S] [--block=N] [--edits-per-second=N] [--seed=N]",
+                   "Swaps the sequence under a running audio thread as fast as it can",
+                   "Renders the Sequencer flat out on one thread while this one hands it "
+                   "a new random sequence --edits-per-second times a second, or as fast as "
+                   "it can, for --seconds (10). Fails if a generator leaks, is deleted "
+                   "twice or played after it's deleted. Build with -fsanitize=thread or "
+                   "-fsanitize=address for the sanitizer to check every access as well.",
+                   stressSequencer });
+
+  app.addCommand({ "test",
+                   "test [category]",
+                   "Runs the unit tests",
+                   "Runs every juce::UnitTest built into the tools, or those in category "
+                   "(e.g. BioSignals), and fails if any expectation did. Needs no board "
+                   "and no audio device.",
+                   test });
+
+  return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "../../Source/WavetableLibrary.h"
+
+namespace BioSignals
+{
+
+OfflineRenderer::OfflineRenderer(const Options& options) :
+    options_(options)
+{ /* Nothing */ }
+
+bool OfflineRenderer::fail(const juce::String& error)
+{
+  error_ = error;
+  return false;
+}
+
+bool OfflineRenderer::open(const juce::File& input)
+{
+  capture_.reset();
+  if (log_.open(input))
+  {
+    streamMs_ = log_.getDurationMs();
+    return true;
+  }
+
+  if (!input.loadFileAsData(capture_))
+    return fail("can't read " + input.getFullPathName());
+  streamMs_ = 1000.0 * 10.0 * (double) capture_.getSize() / options_.baudRate;
+  return true;
+}
+
+std::unique_ptr<WavetableBank> OfflineRenderer::loadBank()
+{
+  if (options_.wavetables == juce::File())
+    return WavetableBank::createSaw();
+
+  WavetableLibrary library;
+  if (!library.open(options_.wavetables))
+    return nullptr;
+  auto bank = library.getBank(options_.wavetableName);
+  if (bank != nullptr)
+    bank->prefault(); // or the first notes' render times include the disk
+  return bank;
+}
+
+FrequencyGenerator* OfflineRenderer::createSequence() const
+{
+  if (!options_.randomSequence)
+    return new FreqSequence(options_.notes);
+
+  auto* generator = new FreqRandom(options_.notes);
+  generator->setSeed(options_.seed);
+  return generator;
+}
+
+void OfflineRenderer::feed(SensorIngest& ingest, double timeMs)
+{
+  if (log_.isOpen())
+  {
+    for (; haveNext_ && next_.hostTimeMs <= timeMs; haveNext_ = log_.readNext(next_))
+    {
+      ingest.handleRecords(next_.device, &next_.record, 1, next_.hostTimeMs);
+      drain(ingest);
+    }
+    return;
+  }
+
+  // whatever the wire would have delivered by now, as one read would
+  const size_t due = (size_t) juce::jlimit(0.0, (double) capture_.getSize(),
+                                           timeMs / 1000.0 * options_.baudRate / 10.0);
+  if (due > captureFed_)
+  {
+    ingest.handleBytes(0, static_cast<const char*>(capture_.getData()) + captureFed_,
+                       (int) (due - captureFed_), timeMs);
+    captureFed_ = due;
+    drain(ingest);
+  }
+}
+
+void OfflineRenderer::drain(SensorIngest& ingest)
+{
+  SensorEvent events[eventBatchSize];
+  while (const int numEvents = ingest.readEvents(events, eventBatchSize))
+    numReadings_ += (juce::uint64) numEvents;
+}
+
+bool OfflineRenderer::render(const juce::File& output)
+{
+  if (!log_.isOpen() && capture_.isEmpty())
+    return fail("nothing to render, open() a stream first");
+  if (options_.notes.empty())
+    return fail("no notes to play");
+
+  std::unique_ptr<juce::AudioFormat> format;
+  if (output.hasFileExtension("wav"))
+    format.reset(new juce::WavAudioFormat());
+  else if (output.hasFileExtension("flac"))
+    format.reset(new juce::FlacAudioFormat());
+  else
+    return fail("can only write .wav or .flac");
+  if (!format->getPossibleBitDepths().contains(options_.bitsPerSample))
+    return fail(format->getFormatName() + " can't do "
+                + juce::String(options_.bitsPerSample) + " bit");
+
+  auto bank = loadBank();
+  if (bank == nullptr)
+    return fail("can't load " + options_.wavetableName + " from "
+                + options_.wavetables.getFullPathName());
+
+  output.deleteFile(); // FileOutputStream appends otherwise
+  std::unique_ptr<juce::FileOutputStream> stream(new juce::FileOutputStream(output));
+  if (stream->failedToOpen())
+    return fail("can't write " + output.getFullPathName());
+  std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(
+      stream.get(), options_.sampleRate, (unsigned int) options_.numChannels,
+      options_.bitsPerSample, {}, 0));
+  if (writer == nullptr)
+    return fail("can't write " + format->getFormatName() + " at those settings");
+  stream.release(); // the writer's now
+
+  // from the top of the stream, the same way every time
+  numReadings_ = 0;
+  peak_ = 0.0f;
+  captureFed_ = 0;
+  haveNext_ = log_.isOpen() && log_.seek(0.0) && log_.readNext(next_);
+
+  SensorIngest ingest;
+  SynthEngine::setUpConditioning(ingest);
+  SynthEngine engine(*bank, &ingest);
+  engine.getParameters().setCurrentAndTarget(VOLUME, options_.volume);
+  engine.getSequencer().setSequence(createSequence());
+  engine.prepareToPlay(options_.blockSize, options_.sampleRate);
+
+  const double seconds = options_.durationSeconds > 0.0
+      ? options_.durationSeconds : streamMs_ / 1000.0 + options_.tailSeconds;
+  const juce::int64 numSamples = (juce::int64) std::ceil(seconds * options_.sampleRate);
+
+  juce::AudioSampleBuffer buffer(options_.numChannels, options_.blockSize);
+  juce::int64 renderTicks = 0;
+  const auto started = juce::Time::getHighResolutionTicks();
+  bool ok = true;
+  for (juce::int64 done = 0; ok && done < numSamples; done += options_.blockSize)
+  {
+    const int count = (int) juce::jmin((juce::int64) options_.blockSize, numSamples - done);
+    feed(ingest, 1000.0 * (double) done / options_.sampleRate);
+
+    const auto blockStarted = juce::Time::getHighResolutionTicks();
+    engine.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, 0, count));
+    renderTicks += juce::Time::getHighResolutionTicks() - blockStarted;
+    peak_ = juce::jmax(peak_, buffer.getMagnitude(0, count));
+
+    ok = writer->writeFromAudioSampleBuffer(buffer, 0, count);
+  }
+  writer.reset(); // finishes off the header
+  elapsedSeconds_ = juce::Time::highResolutionTicksToSeconds(
+      juce::Time::getHighResolutionTicks() - started);
+  renderSeconds_ = juce::Time::highResolutionTicksToSeconds(renderTicks);
+  audioSeconds_ = (double) numSamples / options_.sampleRate;
+
+  engine.releaseResources();
+  return ok || fail("can't write " + output.getFullPathName());
+}
+
+} // namespace BioSignals
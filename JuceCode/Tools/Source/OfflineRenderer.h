@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "../../Source/SensorLog.h"
+#include "../../Source/SynthEngine.h"
+
+namespace BioSignals
+{
+
+/**
+ Plays a recorded performance through the synth without a GUI or an audio
+ device, and writes what it played to a WAV or FLAC file as fast as the CPU
+ will go.
+
+ The input is a .bslog session, played on its recorded timing, or a raw
+ capture: the arduino_dump_*.data text dumps, or sensor_frame.h frames. A raw
+ capture is paced as if it came in over the wire at baudRate, 10 bits a
+ byte, the way the simulator plays it.
+
+ A virtual clock stands in for the host's. Before each block, every reading
+ due by then goes into a SensorIngest stamped with that clock, and the
+ SynthEngine picks it up, as the audio thread does live. The sequence's
+ random walk is seeded too. The same input and options always write the
+ same file, so two renders can be diffed.
+ */
+class OfflineRenderer
+{
+public:
+  struct Options
+  {
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    int bitsPerSample = 24;
+    double baudRate = 9600.0;       // paces raw captures
+    double tailSeconds = 2.0;       // after the last reading
+    double durationSeconds = 0.0;   // 0 = the whole stream and the tail
+    float volume = 0.5f;
+    bool randomSequence = true;     // FreqRandom, or step through in order
+    std::vector<juce::uint8> notes { 60, 62, 64, 65, 67, 69, 71, 72 };
+    juce::int64 seed = 1;
+    juce::File wavetables;          // a .bswl, or the saw built on the spot
+    juce::String wavetableName = "saw";
+  };
+
+  explicit OfflineRenderer(const Options& options);
+
+  /** A .bslog, or failing that a raw capture */
+  bool open(const juce::File& input);
+
+  /** Renders the whole stream to a .wav or .flac. On false, getError() says why */
+  bool render(const juce::File& output);
+
+  const juce::String& getError() const noexcept { return error_; }
+
+  /** How long the stream runs, by its own clock */
+  double getStreamSeconds() const noexcept { return streamMs_ / 1000.0; }
+  double getAudioSeconds() const noexcept { return audioSeconds_; }
+  /** Wall clock time in the engine alone, and for the whole render, encoding included */
+  double getRenderSeconds() const noexcept { return renderSeconds_; }
+  double getElapsedSeconds() const noexcept { return elapsedSeconds_; }
+  juce::uint64 getNumReadings() const noexcept { return numReadings_; }
+  /** The largest magnitude the engine put out, before the file's clipped it to 1 */
+  float getPeak() const noexcept { return peak_; }
+
+private:
+  static constexpr int eventBatchSize = 256;
+
+  std::unique_ptr<WavetableBank> loadBank();
+  FrequencyGenerator* createSequence() const;
+  /** Hands ingest everything due by timeMs */
+  void feed(SensorIngest& ingest, double timeMs);
+  /** Counts what feed() handed over, and keeps the ingest's queue from filling */
+  void drain(SensorIngest& ingest);
+  bool fail(const juce::String& error);
+
+  Options options_;
+
+  SensorLogReader log_;
+  SensorEvent next_;
+  bool haveNext_ = false;
+  juce::MemoryBlock capture_; // when it isn't a log
+  size_t captureFed_ = 0;
+  double streamMs_ = 0.0;
+
+  juce::String error_;
+  double audioSeconds_ = 0.0;
+  double renderSeconds_ = 0.0;
+  double elapsedSeconds_ = 0.0;
+  juce::uint64 numReadings_ = 0;
+  float peak_ = 0.0f;
+
+  JUCE_DECLARE_NON_COPYABLE(OfflineRenderer)
+};
+
+} // namespace BioSignals
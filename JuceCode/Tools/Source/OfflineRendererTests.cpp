@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    OfflineRendererTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include "OfflineRenderer.h"
+#include "../../Source/SensorLog.h"
+
+namespace BioSignals
+{
+
+/**
+ Renders through the OfflineRenderer, the same engine the app plays, and
+ checks what comes out of it: the same file, sample for sample, every time
+ a stream is rendered with the same options, and no clipping at the top of
+ the tempo range.
+ */
+class OfflineRendererTests : public juce::UnitTest
+{
+public:
+  OfflineRendererTests() : juce::UnitTest("Offline render", "BioSignals") {}
+
+  void runTest() override
+  {
+    beginTest("A bundled capture renders the same every time");
+    {
+      const auto capture = findBundledCapture();
+      expect(capture.existsAsFile(),
+             "no ArduinoCode/arduino_analog/arduino_dump_1.data above here or the executable");
+      if (capture.existsAsFile())
+        expectRendersAlike(capture);
+    }
+
+    beginTest("A logged session renders the same every time");
+    {
+      // three seconds of a board warming up and its pulse climbing
+      juce::TemporaryFile log(".bslog");
+      SensorLogWriter writer;
+      expect(writer.open(log.getFile(), 0.0));
+      for (int idx = 0; idx < 300; ++idx)
+      {
+        const auto sensor = (juce::uint8) (idx % 2 == 0 ? TEMP2 : PULSE);
+        const float value = sensor == TEMP2 ? 21.0f + (float) idx * 0.02f
+                                            : 70.0f + (float) idx * 2.0f;
+        writer.write({ { sensor, value, (juce::uint32) (idx * 10) }, 0, (double) idx * 10.0 });
+      }
+      writer.close();
+      expectRendersAlike(log.getFile(), 300);
+    }
+
+    beginTest("A pulse at the tempo's ceiling doesn't clip at full volume");
+    {
+      // a pulse far above maxTempo, a reading every 10 ms or so at 9600 baud
+      juce::String capture;
+      for (int idx = 0; idx < 500; ++idx)
+        capture << (int) PULSE << "2500.00\r\n";
+      juce::TemporaryFile input(".data");
+      expect(input.getFile().replaceWithText(capture));
+
+      for (bool randomSequence : { true, false })
+      {
+        OfflineRenderer::Options options;
+        options.volume = 1.0f;
+        options.randomSequence = randomSequence;
+        if (!randomSequence)
+          options.notes = { 48 }; // every tail the same pitch
+        OfflineRenderer renderer(options);
+        juce::TemporaryFile output(".wav");
+        expect(renderer.open(input.getFile()) && renderer.render(output.getFile()),
+               renderer.getError());
+        expect(renderer.getPeak() > 0.1f, "didn't play anything");
+        expect(renderer.getPeak() < 1.0f, "peaked at " + juce::String(renderer.getPeak()));
+      }
+    }
+  }
+
+private:
+  /** arduino_dump_1.data, from the first directory up from here or the executable that has it */
+  static juce::File findBundledCapture()
+  {
+    for (auto start : { juce::File::getCurrentWorkingDirectory(),
+                        juce::File::getSpecialLocation(juce::File::currentExecutableFile) })
+    {
+      for (auto directory = start; !directory.isRoot(); directory = directory.getParentDirectory())
+      {
+        auto capture = directory.getChildFile("ArduinoCode/arduino_analog/arduino_dump_1.data");
+        if (capture.existsAsFile())
+          return capture;
+      }
+    }
+    return {};
+  }
+
+  /**
+   Renders input three times, twice with one renderer and once with another,
+   as float WAVs, and expects the same bytes each time. numReadings, if
+   given, is how many readings it has to have played
+   */
+  void expectRendersAlike(const juce::File& input, int numReadings = -1)
+  {
+    OfflineRenderer::Options options;
+    options.bitsPerSample = 32;
+    OfflineRenderer first(options), second(options);
+    juce::TemporaryFile once(".wav"), again(".wav"), elsewhere(".wav");
+    expect(first.open(input) && first.render(once.getFile()), first.getError());
+    expect(first.getPeak() > 0.0f, "rendered silence");
+    if (numReadings >= 0)
+      expectEquals((int) first.getNumReadings(), numReadings);
+    expect(first.render(again.getFile()), first.getError());
+    expect(second.open(input) && second.render(elsewhere.getFile()), second.getError());
+
+    juce::MemoryBlock expected, rendered;
+    expect(once.getFile().loadFileAsData(expected));
+    for (auto* file : { &again, &elsewhere })
+    {
+      expect(file->getFile().loadFileAsData(rendered));
+      expectEquals((int) rendered.getSize(), (int) expected.getSize());
+      const auto* a = static_cast<const char*>(expected.getData());
+      const auto* b = static_cast<const char*>(rendered.getData());
+      const size_t length = juce::jmin(expected.getSize(), rendered.getSize());
+      const size_t differs = (size_t) (std::mismatch(a, a + length, b).first - a);
+      const juce::String which = file == &again ? "rendering again" : "another renderer";
+      expect(differs == length, which + " wrote a different byte at " + juce::String((int) differs));
+    }
+  }
+};
+
+static OfflineRendererTests offlineRendererTests;
+
+} // namespace BioSignals
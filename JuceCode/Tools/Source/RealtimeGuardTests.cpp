@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    RealtimeGuardTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <cstdlib>
+#include "../../Source/RealtimeGuard.h"
+
+namespace BioSignals
+{
+
+/**
+ Does what the audio thread mustn't inside a ScopedRealtimeSection and checks
+ RealtimeGuard saw it, under the right name. Only builds with
+ BIOSIGNALS_REALTIME_CHECKS hook anything, in others there's nothing to test.
+ */
+class RealtimeGuardTests : public juce::UnitTest
+{
+public:
+  RealtimeGuardTests() : juce::UnitTest("RealtimeGuard", "BioSignals") {}
+
+  void runTest() override
+  {
+    if (!RealtimeGuard::isAvailable())
+      return;
+
+    RealtimeGuard::setLogging(false);
+    RealtimeGuard::reset();
+
+    beginTest("Nothing counts outside a section");
+    {
+      allocateAndFree();
+      const juce::ScopedLock locked(lock_);
+      expectEquals(RealtimeGuard::getNumViolations(), 0);
+    }
+
+    beginTest("Allocating and freeing in a section");
+    {
+      {
+        ScopedRealtimeSection section;
+        allocateAndFree();
+      }
+#if defined(__GLIBC__)
+      expectViolations({ "malloc", "free" });
+#else
+      expectViolations({ "operator new", "operator delete" });
+#endif
+    }
+
+    beginTest("Taking a lock in a section");
+    {
+      RealtimeGuard::reset();
+      {
+        ScopedRealtimeSection section;
+        const juce::ScopedLock locked(lock_);
+      }
+#if defined(__GLIBC__)
+      expectViolations({ "pthread_mutex_lock" });
+#else
+      expectViolations({}); // not hooked off glibc
+#endif
+    }
+
+    beginTest("Sections nest");
+    {
+      RealtimeGuard::reset();
+      {
+        ScopedRealtimeSection outer;
+        {
+          ScopedRealtimeSection inner;
+        }
+        allocateAndFree();
+      }
+      allocateAndFree();
+      expectEquals(RealtimeGuard::getNumViolations(), 2);
+    }
+
+    RealtimeGuard::reset();
+    RealtimeGuard::setLogging(true);
+  }
+
+private:
+  /** Through whichever of malloc() and operator new this build hooks */
+  static void allocateAndFree()
+  {
+#if defined(__GLIBC__)
+    // volatile, or the pair can be optimised away
+    void* volatile block = std::malloc(64);
+    std::free(block);
+#else
+    int* volatile block = new int(1);
+    delete block;
+#endif
+  }
+
+  /** Exactly these have been seen since the last reset(), once each */
+  void expectViolations(std::initializer_list<const char*> expected)
+  {
+    const auto violations = RealtimeGuard::getViolations();
+    expectEquals(RealtimeGuard::getNumViolations(), (int) expected.size());
+    expectEquals((int) violations.size(), (int) expected.size());
+
+    for (auto* what : expected)
+    {
+      auto found = std::find_if(violations.begin(), violations.end(),
+                                [what] (const RealtimeGuard::Violation& violation)
+                                { return violation.what == what; });
+      expect(found != violations.end(), juce::String("no ") + what + " was seen");
+      if (found != violations.end())
+      {
+        expectEquals(found->count, 1);
+        expect(found->stackTrace.isNotEmpty());
+      }
+    }
+  }
+
+  juce::CriticalSection lock_;
+};
+
+static RealtimeGuardTests realtimeGuardTests;
+
+} // namespace BioSignals
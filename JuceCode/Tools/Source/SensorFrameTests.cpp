@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    SensorFrameTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <vector>
+#include "sensor_frame.h"
+#include "../../Source/SensorDecoder.h"
+
+namespace BioSignals
+{
+
+/**
+ Round trips sensor_frame.h frames through the board's encoder and the
+ host's decoders, so the wire protocol can be checked on a desktop with no
+ board attached. Run with `BioSignalsTools test`.
+ */
+class SensorFrameTests : public juce::UnitTest
+{
+public:
+  SensorFrameTests() : juce::UnitTest("sensor_frame.h round trip", "BioSignals") {}
+
+  void runTest() override
+  {
+    auto random = getRandom();
+
+    beginTest("Values saturate and round to hundredths");
+    expectEquals((int) sensorFrameValueFromFloat(23.456f), 2346);
+    expectEquals((int) sensorFrameValueFromFloat(-23.456f), -2346);
+    expectEquals((int) sensorFrameValueFromFloat(1000.0f), 32767);
+    expectEquals((int) sensorFrameValueFromFloat(-1000.0f), -32768);
+    expectEquals((int) sensorFrameValueFromFloat(std::nanf("")), 0);
+
+    beginTest("Encoded frames hold no zeros but the delimiter");
+    for (int count = 1; count <= SENSOR_FRAME_MAX_RECORDS; ++count)
+    {
+      // zero timestamps and values put zeros all through the raw frame
+      const auto frame = makeFrame(0, count, [](int) { return 0.0f; });
+      uint8_t encoded[SENSOR_FRAME_MAX_ENCODED];
+      const int length = sensorFrameEncode(&frame, encoded);
+      expect(length <= SENSOR_FRAME_MAX_ENCODED);
+      expectEquals((int) encoded[length - 1], 0);
+      expect(memchr(encoded, 0, (size_t) (length - 1)) == nullptr);
+    }
+
+    beginTest("Every frame comes back, however the stream is split up");
+    std::vector<SensorFrame> sent;
+    for (int idx = 0; idx < 200; ++idx)
+      sent.push_back(makeFrame((uint32_t) random.nextInt(), 1 + random.nextInt(SENSOR_FRAME_MAX_RECORDS),
+                               [&](int) { return (random.nextFloat() - 0.5f) * 700.0f; }));
+    const auto stream = encode(sent);
+    for (int readSize : { 1, 2, 7, 64, (int) stream.size() })
+    {
+      SensorFrameDecoder decoder;
+      expectFramesEqual(decodeAll(decoder, stream, readSize), sent);
+      expectEquals((int) decoder.frames, (int) sent.size());
+      expectEquals((int) (decoder.crcErrors + decoder.formatErrors), 0);
+    }
+
+    const std::vector<SensorFrame> pair { makeFrame(0x04030201, 3, [](int rec) { return 2.57f * (rec + 1); }),
+                                          makeFrame(0x05060708, 2, [](int rec) { return -2.0f - rec; }) };
+
+    beginTest("Resyncs on the next delimiter after garbage");
+    {
+      // noise then a delimiter, as when the port opens mid frame
+      std::vector<uint8_t> noisy { 0x13, 0x37, 0xFF, 0x42, 0x00 };
+      const auto frames = encode(pair);
+      noisy.insert(noisy.end(), frames.begin(), frames.end());
+      SensorFrameDecoder decoder;
+      expectFramesEqual(decodeAll(decoder, noisy, 3), pair);
+      expectEquals((int) decoder.formatErrors, 1);
+    }
+    {
+      // noise with no delimiter runs into the first frame and takes it with it
+      std::vector<uint8_t> noisy { 0x13, 0x37, 0x42 };
+      const auto frames = encode(pair);
+      noisy.insert(noisy.end(), frames.begin(), frames.end());
+      SensorFrameDecoder decoder;
+      expectFramesEqual(decodeAll(decoder, noisy, 5), { pair[1] });
+      expectEquals((int) decoder.frames, 1);
+    }
+    {
+      // more garbage than any frame could hold overflows, and is dropped whole
+      std::vector<uint8_t> noisy(3 * SENSOR_FRAME_MAX_ENCODED, 0x55);
+      noisy.push_back(0x00);
+      const auto frames = encode(pair);
+      noisy.insert(noisy.end(), frames.begin(), frames.end());
+      SensorFrameDecoder decoder;
+      expectFramesEqual(decodeAll(decoder, noisy, 16), pair);
+      expectEquals((int) decoder.formatErrors, 1);
+    }
+
+    beginTest("A bad checksum drops that frame and no other");
+    {
+      // every raw byte of the first frame is non zero, so it's one COBS run
+      // and byte 3 is the low byte of its timestamp
+      auto corrupted = encode(pair);
+      expectEquals((int) corrupted[0], SENSOR_FRAME_HEADER_SIZE + 3 * 3 + 2 + 1);
+      corrupted[3] ^= 0x80;
+      SensorFrameDecoder decoder;
+      expectFramesEqual(decodeAll(decoder, corrupted, 4), { pair[1] });
+      expectEquals((int) decoder.crcErrors, 1);
+      expectEquals((int) decoder.formatErrors, 0);
+    }
+
+    beginTest("The host decoder switches to frames and hands out records");
+    {
+      // a board just rebuilt with frames, after a line of the old protocol.
+      // Up to the first delimiter is one bad frame, so the first goes with it
+      const char line[] = "T2: 23.50\r\n";
+      std::vector<uint8_t> bytes(line, line + sizeof(line) - 1);
+      const auto frames = encode({ pair[0], pair[1], pair[0], pair[1] });
+      bytes.insert(bytes.end(), frames.begin(), frames.end());
+      const std::vector<SensorFrame> expected { pair[1], pair[0], pair[1] };
+
+      SensorStreamDecoder decoder;
+      SensorRecord records[2]; // fewer than a frame, so frames come out over calls
+      std::vector<SensorRecord> decoded;
+      int offset = 0;
+      for (;;)
+      {
+        const auto result = decoder.decode(bytes.data() + offset, (int) bytes.size() - offset,
+                                           records, 2);
+        decoded.insert(decoded.end(), records, records + result.numRecords);
+        offset += result.bytesConsumed;
+        if (result.numRecords == 0 && offset == (int) bytes.size())
+          break;
+      }
+      expect(decoder.getWireFormat() == SensorStreamDecoder::BINARY_FRAMES);
+      expectEquals((int) decoder.getFrameDecoder().frames, 3);
+
+      int idx = 0;
+      expectEquals((int) decoded.size(), 2 * pair[1].count + pair[0].count);
+      for (auto& frame : expected)
+        for (int rec = 0; rec < frame.count && idx < (int) decoded.size(); ++rec, ++idx)
+        {
+          expectEquals((int) decoded[(size_t) idx].sensor, (int) frame.records[rec].sensor);
+          expectEquals(decoded[(size_t) idx].value, sensorFrameValueToFloat(frame.records[rec].value));
+          expectEquals((juce::int64) decoded[(size_t) idx].deviceTime, (juce::int64) frame.timestamp);
+        }
+    }
+  }
+
+private:
+  template <typename ValueFunction>
+  static SensorFrame makeFrame(uint32_t timestamp, int count, ValueFunction value)
+  {
+    SensorFrame frame;
+    sensorFrameBegin(&frame, timestamp);
+    for (int rec = 0; rec < count; ++rec)
+      sensorFrameAdd(&frame, (uint8_t) (rec + 1), value(rec));
+    return frame;
+  }
+
+  static std::vector<uint8_t> encode(const std::vector<SensorFrame>& frames)
+  {
+    std::vector<uint8_t> stream;
+    for (auto& frame : frames)
+    {
+      uint8_t encoded[SENSOR_FRAME_MAX_ENCODED];
+      const int length = sensorFrameEncode(&frame, encoded);
+      stream.insert(stream.end(), encoded, encoded + length);
+    }
+    return stream;
+  }
+
+  /** Feeds stream in readSize pieces, the way serial reads come in */
+  static std::vector<SensorFrame> decodeAll(SensorFrameDecoder& decoder,
+                                            const std::vector<uint8_t>& stream, int readSize)
+  {
+    sensorFrameDecoderReset(&decoder);
+    std::vector<SensorFrame> frames;
+    for (size_t start = 0; start < stream.size(); start += (size_t) readSize)
+    {
+      const int numBytes = (int) juce::jmin(stream.size() - start, (size_t) readSize);
+      for (int consumed = 0; consumed < numBytes;)
+      {
+        SensorFrame frame;
+        bool gotFrame = false;
+        consumed += sensorFrameDecode(&decoder, stream.data() + start + consumed,
+                                      numBytes - consumed, &frame, &gotFrame);
+        if (gotFrame)
+          frames.push_back(frame);
+      }
+    }
+    return frames;
+  }
+
+  void expectFramesEqual(const std::vector<SensorFrame>& actual,
+                         const std::vector<SensorFrame>& expected)
+  {
+    expectEquals((int) actual.size(), (int) expected.size());
+    for (size_t idx = 0; idx < juce::jmin(actual.size(), expected.size()); ++idx)
+    {
+      expectEquals((juce::int64) actual[idx].timestamp, (juce::int64) expected[idx].timestamp);
+      expectEquals((int) actual[idx].count, (int) expected[idx].count);
+      for (int rec = 0; rec < juce::jmin(actual[idx].count, expected[idx].count); ++rec)
+      {
+        expectEquals((int) actual[idx].records[rec].sensor, (int) expected[idx].records[rec].sensor);
+        expectEquals((int) actual[idx].records[rec].value, (int) expected[idx].records[rec].value);
+      }
+    }
+  }
+};
+
+static SensorFrameTests sensorFrameTests;
+
+} // namespace BioSignals
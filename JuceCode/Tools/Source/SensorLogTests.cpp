@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    SensorLogTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <vector>
+#include "../../Source/SensorLog.h"
+
+namespace BioSignals
+{
+
+/**
+ Writes .bslog files with SensorLogWriter and reads them back with
+ SensorLogReader: every event intact across several chunks, seeking into
+ the middle of them, and what's left of a log that was never closed or was
+ cut short.
+ */
+class SensorLogTests : public juce::UnitTest
+{
+public:
+  SensorLogTests() : juce::UnitTest("SensorLog round trip", "BioSignals") {}
+
+  void runTest() override
+  {
+    auto random = getRandom();
+    const auto written = makeEvents(random, 3000);
+    const auto events = asLogged(written);
+    juce::TemporaryFile logFile(".bslog");
+
+    beginTest("Every event comes back as it was written");
+    {
+      SensorLogWriter writer;
+      expect(writer.open(logFile.getFile(), 0.0));
+      for (auto& event : written)
+        writer.write(event);
+      writer.close();
+      expectEquals((int) writer.getNumEventsWritten(), (int) events.size());
+
+      SensorLogReader reader;
+      expect(reader.open(logFile.getFile()));
+      expect(!reader.wasRecovered());
+      // 1024 events a chunk, as each second of these holds more than that
+      expectEquals(reader.getNumChunks(), 3);
+      expectEquals((int) reader.getNumEvents(), (int) events.size());
+      expectEquals(reader.getDurationMs(), events.back().hostTimeMs);
+      expectEventsEqual(readAll(reader), events);
+    }
+
+    beginTest("Seeks to the first event at or after a time");
+    {
+      SensorLogReader reader;
+      expect(reader.open(logFile.getFile()));
+      const double lastMs = events.back().hostTimeMs;
+      for (double target : { -5.0, 0.0, events[1024].hostTimeMs, events[1500].hostTimeMs - 0.0005,
+                             lastMs / 3.0, lastMs * 0.9, lastMs })
+      {
+        size_t first = 0;
+        while (first < events.size()
+               && std::llround(events[first].hostTimeMs * 1000.0) < (juce::int64) (target * 1000.0))
+          ++first;
+
+        expect(reader.seek(target), "can't seek to " + juce::String(target));
+        std::vector<SensorEvent> read;
+        SensorEvent event;
+        while (read.size() < 50 && reader.readNext(event))
+          read.push_back(event);
+        const auto end = events.begin() + (std::ptrdiff_t) juce::jmin(events.size(), first + 50);
+        expectEventsEqual(read, std::vector<SensorEvent>(events.begin() + (std::ptrdiff_t) first, end));
+      }
+      expect(!reader.seek(lastMs + 1.0));
+    }
+
+    juce::MemoryBlock whole;
+    expect(logFile.getFile().loadFileAsData(whole));
+    const size_t indexOffset = whole.getSize() - (8 + 3 * 28 + 12);
+    const auto lastChunkOffset = (size_t) juce::ByteOrder::littleEndianInt64(
+        static_cast<const char*>(whole.getData()) + indexOffset + 8 + 2 * 28);
+    const std::vector<SensorEvent> firstTwoChunks(events.begin(), events.begin() + 2048);
+
+    beginTest("A log that was never closed is indexed by walking its chunks");
+    {
+      // what a crash leaves once the recorder has flushed
+      SensorLogWriter writer;
+      juce::TemporaryFile crashed(".bslog");
+      expect(writer.open(crashed.getFile(), 0.0));
+      for (auto& event : written)
+        writer.write(event);
+      writer.flush();
+
+      SensorLogReader reader;
+      expect(reader.open(crashed.getFile()));
+      expect(reader.wasRecovered());
+      expectEquals(reader.getNumChunks(), 3);
+      expectEquals(reader.getDurationMs(), events.back().hostTimeMs);
+      expectEventsEqual(readAll(reader), events);
+      writer.close();
+    }
+    expectRecovered(whole, indexOffset, events, "cut at the index");
+
+    beginTest("A chunk cut short is lost, and nothing before it");
+    expectRecovered(whole, indexOffset - 10, firstTwoChunks, "cut in the last chunk");
+    expectRecovered(whole, lastChunkOffset + 10, firstTwoChunks, "cut in the last chunk's header");
+    expectRecovered(whole, 16, {}, "cut after the header");
+
+    beginTest("An index that points anywhere but a chunk is rebuilt");
+    {
+      juce::MemoryBlock damaged(whole);
+      auto* bytes = static_cast<juce::uint8*>(damaged.getData());
+      // the second chunk's offset, into the middle of the first
+      bytes[indexOffset + 8 + 28] = 40;
+      bytes[indexOffset + 8 + 28 + 1] = 0;
+      expectRecovered(damaged, damaged.getSize(), events, "bad chunk offset");
+    }
+
+    beginTest("Not a log at all");
+    {
+      juce::TemporaryFile cut(".bslog");
+      expect(cut.getFile().replaceWithData(whole.getData(), 10));
+      SensorLogReader reader;
+      expect(!reader.open(cut.getFile()));
+    }
+  }
+
+private:
+  /** Readings from three boards and the odd one from a fourth, about a ms apart */
+  static std::vector<SensorEvent> makeEvents(juce::Random& random, int numEvents)
+  {
+    std::vector<SensorEvent> events((size_t) numEvents);
+    juce::uint32 deviceTimes[16] = { 1000, 0xffffff00, 5 }; // the second wraps
+    juce::int64 micros = 0;
+    for (int idx = 0; idx < numEvents; ++idx)
+    {
+      auto& event = events[(size_t) idx];
+      event.device = (juce::uint8) (idx % 250 == 7 ? 15 : idx % 3);
+      event.record.sensor = (juce::uint8) (idx % 97 == 0 ? 42 : 1 + idx % 6);
+      event.record.deviceTime = deviceTimes[event.device] += (juce::uint32) random.nextInt(20);
+
+      switch (idx % 4)
+      {
+        case 0:  event.record.value = (float) (random.nextInt(20001) - 10000) / 100.0f; break;
+        case 1:  event.record.value = random.nextFloat() * 1000.0f; break;
+        case 2:  event.record.value = 1.0e6f + (float) random.nextInt(100); break;
+        default: event.record.value = (float) (random.nextInt(401) - 200) / 100.0f; break;
+      }
+
+      micros += random.nextInt(1500);
+      event.hostTimeMs = (double) micros / 1000.0;
+    }
+    // one out of order, which is logged at the time of the one before
+    events[500].hostTimeMs = events[499].hostTimeMs - 3.0;
+    return events;
+  }
+
+  /** events with the times the writer keeps: whole microseconds, never going backwards */
+  static std::vector<SensorEvent> asLogged(std::vector<SensorEvent> events)
+  {
+    juce::int64 lastMicros = 0;
+    for (auto& event : events)
+    {
+      lastMicros = juce::jmax(lastMicros, (juce::int64) (event.hostTimeMs * 1000.0));
+      event.hostTimeMs = (double) lastMicros / 1000.0;
+    }
+    return events;
+  }
+
+  static std::vector<SensorEvent> readAll(SensorLogReader& reader)
+  {
+    std::vector<SensorEvent> events;
+    SensorEvent event;
+    while (reader.readNext(event))
+      events.push_back(event);
+    return events;
+  }
+
+  void expectRecovered(const juce::MemoryBlock& whole, size_t length,
+                       const std::vector<SensorEvent>& expected, const juce::String& what)
+  {
+    juce::TemporaryFile cut(".bslog");
+    expect(cut.getFile().replaceWithData(whole.getData(), length));
+    SensorLogReader reader;
+    expect(reader.open(cut.getFile()), what);
+    expect(reader.wasRecovered(), what);
+    expectEquals((int) reader.getNumEvents(), (int) expected.size());
+    expectEventsEqual(readAll(reader), expected);
+  }
+
+  void expectEventsEqual(const std::vector<SensorEvent>& actual,
+                         const std::vector<SensorEvent>& expected)
+  {
+    expectEquals((int) actual.size(), (int) expected.size());
+    for (size_t idx = 0; idx < juce::jmin(actual.size(), expected.size()); ++idx)
+    {
+      auto& got = actual[idx];
+      auto& want = expected[idx];
+      expectEquals((int) got.device, (int) want.device);
+      expectEquals((int) got.record.sensor, (int) want.record.sensor);
+      expectEquals((juce::int64) got.record.deviceTime, (juce::int64) want.record.deviceTime);
+      expect(memcmp(&got.record.value, &want.record.value, sizeof(float)) == 0,
+             juce::String(got.record.value) + " came back for " + juce::String(want.record.value));
+      expectEquals(got.hostTimeMs, want.hostTimeMs);
+    }
+  }
+};
+
+static SensorLogTests sensorLogTests;
+
+} // namespace BioSignals
@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    SensorSimulator.cpp
+
+  ==============================================================================
+*/
+
+#include "SensorSimulator.h"
+#include "../../Source/SensorParser.h"
+#include "sensor_frame.h"
+
+#include <chrono>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace BioSignals
+{
+
+using Clock = std::chrono::steady_clock;
+
+// stop() is called from the SIGINT handler
+static_assert(std::atomic<bool>::is_always_lock_free, "shouldStop_ has to be lock free");
+
+SensorSimulator::SensorSimulator(const Options& options) :
+    options_(options)
+{ /* Nothing */ }
+
+SensorSimulator::~SensorSimulator()
+{
+  if (options_.linkPath.isNotEmpty())
+    unlink(options_.linkPath.toRawUTF8());
+  if (master_ != -1)
+    close(master_);
+}
+
+bool SensorSimulator::addCapture(const juce::File& file)
+{
+  juce::MemoryBlock data;
+  if (!file.loadFileAsData(data))
+    return false;
+
+  auto* text = static_cast<const char*>(data.getData());
+  const size_t size = data.getSize();
+
+  // one message per line, terminator included, so pacing matches the wire
+  SensorLineParser parser;
+  size_t start = 0;
+  juce::uint32 device_ms = 0;
+  while (start < size)
+  {
+    auto* newline = static_cast<const char*>(memchr(text + start, '\n', size - start));
+    const size_t end = newline != nullptr ? (size_t) (newline - text) + 1 : size;
+
+    if (!options_.binaryFrames)
+    {
+      appendMessage(text + start, end - start);
+    }
+    else
+    {
+      // what the sketch sends with USE_BINARY_FRAMES, one reading per frame
+      SensorRecord record;
+      int numRecords = parser.parse(text + start, (int) (end - start), &record, 1).numRecords;
+      // a last line with no newline stays in the parser until it's ended
+      if (numRecords == 0 && newline == nullptr)
+        numRecords = parser.parse("\n", 1, &record, 1).numRecords;
+      if (numRecords == 1)
+      {
+        SensorFrame frame;
+        sensorFrameBegin(&frame, device_ms);
+        sensorFrameAdd(&frame, record.sensor, record.value);
+        juce::uint8 encoded[SENSOR_FRAME_MAX_ENCODED];
+        appendMessage(reinterpret_cast<const char*>(encoded),
+                      sensorFrameEncode(&frame, encoded));
+      }
+      device_ms += (juce::uint32) (1000.0 * 10.0 * (double) (end - start)
+                                   / options_.baudRate);
+    }
+    start = end;
+  }
+  return true;
+}
+
+void SensorSimulator::appendMessage(const char* data, size_t length)
+{
+  messages_.push_back({ payload_.size(), length });
+  payload_.insert(payload_.end(), data, data + length);
+}
+
+juce::String SensorSimulator::open()
+{
+  master_ = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_ == -1 || grantpt(master_) != 0 || unlockpt(master_) != 0)
+    return {};
+  fcntl(master_, F_SETFL, fcntl(master_, F_GETFL) | O_NONBLOCK);
+  slavePath_ = ptsname(master_);
+
+  // start the slave out raw, a fresh pty echoes and cooks lines. the
+  // settings stick around while we hold the master
+  int slave = ::open(slavePath_.toRawUTF8(), O_RDWR | O_NOCTTY);
+  if (slave != -1)
+  {
+    struct termios options;
+    if (tcgetattr(slave, &options) == 0)
+    {
+      cfmakeraw(&options);
+      tcsetattr(slave, TCSANOW, &options);
+    }
+    ::close(slave);
+  }
+
+  if (options_.linkPath.isNotEmpty())
+  {
+    unlink(options_.linkPath.toRawUTF8());
+    if (symlink(slavePath_.toRawUTF8(), options_.linkPath.toRawUTF8()) != 0)
+      fprintf(stderr, "can't create link %s\n", options_.linkPath.toRawUTF8());
+  }
+  return slavePath_;
+}
+
+bool SensorSimulator::writeAll(const char* data, size_t length)
+{
+  while (length > 0 && !shouldStop_)
+  {
+    const ssize_t written = ::write(master_, data, length);
+    if (written > 0)
+    {
+      data += written;
+      length -= (size_t) written;
+      continue;
+    }
+    if (written == -1 && errno != EAGAIN && errno != EINTR && errno != EIO)
+      return false;
+
+    // the pty is full (the host isn't keeping up) or nobody has the slave
+    // open. either way wait, and count it
+    const auto waitStart = Clock::now();
+    struct pollfd pfd;
+    pfd.fd = master_;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    poll(&pfd, 1, 100);
+    if (pfd.revents & POLLHUP)
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stalledSeconds_ += std::chrono::duration<double>(Clock::now() - waitStart).count();
+  }
+  return !shouldStop_;
+}
+
+void SensorSimulator::printStats(double elapsedSeconds, bool final)
+{
+  // a run stopped straight away may not have taken measurable time
+  auto perSecond = [] (double amount, double seconds) { return seconds > 0.0 ? amount / seconds : 0.0; };
+
+  if (final)
+  {
+    printf("sent %llu lines, %llu bytes in %.2f s: %.0f lines/s, %.0f bytes/s, "
+           "stalled %.1f%% of the time\n",
+           (unsigned long long) linesSent_, (unsigned long long) bytesSent_, elapsedSeconds,
+           perSecond((double) linesSent_, elapsedSeconds),
+           perSecond((double) bytesSent_, elapsedSeconds),
+           100.0 * perSecond(stalledSeconds_, elapsedSeconds));
+  }
+  else
+  {
+    // since the last report, which a long stall can make more than a second
+    // ago; a growing stall share means the host has fallen behind
+    const double interval = elapsedSeconds - lastReportSeconds_;
+    printf("%8.1f s  %8.0f lines/s  stalled %5.1f%%\n", elapsedSeconds,
+           perSecond((double) (linesSent_ - lastLines_), interval),
+           100.0 * perSecond(stalledSeconds_ - lastStalled_, interval));
+    lastLines_ = linesSent_;
+    lastStalled_ = stalledSeconds_;
+    lastReportSeconds_ = elapsedSeconds;
+  }
+  fflush(stdout);
+}
+
+void SensorSimulator::run()
+{
+  if (messages_.empty() || master_ == -1)
+    return;
+
+  // nothing gets played until someone is listening
+  printf("waiting for a reader on %s\n", slavePath_.toRawUTF8());
+  fflush(stdout);
+  for (;;)
+  {
+    struct pollfd pfd;
+    pfd.fd = master_;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    poll(&pfd, 1, 100);
+    if (shouldStop_)
+      return;
+    if (!(pfd.revents & POLLHUP))
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  printf("reader connected, playing %d lines\n", (int) messages_.size());
+
+  juce::Random random(options_.seed);
+  const double secondsPerByte = 10.0 / (options_.baudRate * options_.speed);
+  const int burstSize = juce::jmax(1, options_.burstSize);
+
+  const auto start = Clock::now();
+  auto nextReport = start + std::chrono::seconds(1);
+  double scheduled = 0.0; // wire time of the data queued so far
+  double lastSend = 0.0;
+  std::vector<char> burst;
+  int linesInBurst = 0;
+
+  for (size_t idx = 0; !shouldStop_; ++idx)
+  {
+    if (idx == messages_.size())
+    {
+      if (!options_.loop)
+        break;
+      idx = 0;
+    }
+
+    const auto& message = messages_[idx];
+    burst.insert(burst.end(), payload_.data() + message.offset,
+                 payload_.data() + message.offset + message.length);
+    scheduled += (double) message.length * secondsPerByte;
+    const bool lastMessage = idx + 1 == messages_.size() && !options_.loop;
+    if (++linesInBurst < burstSize && !lastMessage)
+      continue;
+
+    if (!options_.maxThroughput)
+    {
+      double when = scheduled;
+      if (options_.jitterMs > 0.0)
+        when += (2.0 * random.nextDouble() - 1.0) * options_.jitterMs / 1000.0;
+      when = juce::jmax(when, lastSend); // jitter never reorders
+      lastSend = when;
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(when)));
+    }
+
+    if (!writeAll(burst.data(), burst.size()))
+      break;
+    linesSent_ += (juce::uint64) linesInBurst;
+    bytesSent_ += burst.size();
+    burst.clear();
+    linesInBurst = 0;
+
+    const auto now = Clock::now();
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+    if (now >= nextReport)
+    {
+      printStats(elapsed, false);
+      nextReport += std::chrono::seconds(1);
+    }
+    if (options_.durationSeconds > 0.0 && elapsed >= options_.durationSeconds)
+      break;
+  }
+
+  printStats(std::chrono::duration<double>(Clock::now() - start).count(), true);
+}
+
+} // namespace BioSignals
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    SensorSimulator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+namespace BioSignals
+{
+
+/**
+ Pretends to be an arduino_analog.ino board on the far side of a pseudo-terminal.
+
+ Recorded captures (the arduino_dump_*.data text dumps, or anything else in the
+ line protocol) are replayed into the pty master. The app connects to the
+ slave end exactly like it connects to hardware, e.g.
+
+   BIOSIGNALS_SERIAL_PORT=/dev/pts/3 ./SIGMusicSineSynth
+
+ Playback is paced by how long each line takes on the wire at the simulated
+ baud rate, optionally sped up, jittered or clumped into bursts. In max mode
+ every write goes out as soon as the pty has room, so the reported rate is
+ how many lines per second the host actually drains.
+ */
+class SensorSimulator
+{
+public:
+  struct Options
+  {
+    double baudRate = 9600.0;    // paces realtime playback, 10 bits per byte
+    double speed = 1.0;          // N x realtime
+    bool maxThroughput = false;  // ignore pacing altogether
+    double jitterMs = 0.0;       // +/- uniform jitter on every send time
+    int burstSize = 1;           // lines held back and written together
+    bool binaryFrames = false;   // re-encode records as sensor_frame.h frames
+    bool loop = false;
+    double durationSeconds = 0.0; // 0 = until the captures run out
+    juce::int64 seed = 1;
+    juce::String linkPath;       // optional symlink to the slave
+  };
+
+  explicit SensorSimulator(const Options& options);
+  ~SensorSimulator();
+
+  /** Load one capture; its lines are appended to the playback list */
+  bool addCapture(const juce::File& file);
+
+  /** Open the pty pair. Returns the slave path, or an empty string */
+  juce::String open();
+
+  /** Play everything back, printing throughput once a second */
+  void run();
+
+  /** Ask run() to return, safe to call from a signal handler */
+  void stop() noexcept { shouldStop_ = true; }
+
+private:
+  struct Message
+  {
+    size_t offset; // into payload_
+    size_t length;
+  };
+
+  void appendMessage(const char* data, size_t length);
+  bool writeAll(const char* data, size_t length);
+  void printStats(double elapsedSeconds, bool final);
+
+  Options options_;
+  std::vector<char> payload_;
+  std::vector<Message> messages_;
+  int master_ = -1;
+  juce::String slavePath_;
+  std::atomic<bool> shouldStop_ { false }; // lock free, so fine in a signal handler
+
+  juce::uint64 linesSent_ = 0;
+  juce::uint64 bytesSent_ = 0;
+  double stalledSeconds_ = 0.0; // waiting for the host to make room
+  juce::uint64 lastLines_ = 0;
+  double lastStalled_ = 0.0;
+  double lastReportSeconds_ = 0.0;
+
+  JUCE_DECLARE_NON_COPYABLE(SensorSimulator)
+};
+
+} // namespace BioSignals
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    SequencerTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <vector>
+#include "../../Source/Sequencer.h"
+#include "../../Source/WavetableBank.h"
+
+namespace BioSignals
+{
+
+/**
+ Pins down the Sequencer's clock: rendered in blocks that no step period
+ divides, step n still has to land within a sample of n * 60 * fs / tempo,
+ however many steps in, rather than on the block boundary after it.
+ */
+class SequencerTests : public juce::UnitTest
+{
+public:
+  SequencerTests() : juce::UnitTest("Sequencer step timing", "BioSignals") {}
+
+  void runTest() override
+  {
+    auto bank = WavetableBank::createSaw();
+
+    struct Case { double sampleRate; int blockSize; double tempo; int numSteps; };
+    for (auto c : { Case { 48000.0, 37, 2000.0, 400 }, Case { 48000.0, 37, 333.3, 200 },
+                    Case { 44100.0, 127, 127.7, 100 }, Case { 48000.0, 511, 10.0, 8 },
+                    Case { 96000.0, 1, 1999.9, 50 } })
+    {
+      beginTest(juce::String(c.tempo) + " steps/min at " + juce::String(c.sampleRate)
+                + " Hz in blocks of " + juce::String(c.blockSize));
+
+      VoicePool voices(*bank);
+      std::vector<juce::int64> steps;
+      auto* recorder = new StepRecorder(steps);
+      Sequencer sequencer(voices, recorder, c.tempo);
+      recorder->sequencer = &sequencer;
+      sequencer.prepareToPlay(c.blockSize, c.sampleRate);
+
+      const double period = 60.0 * c.sampleRate / c.tempo;
+      const auto length = (juce::int64) std::ceil(period * (c.numSteps - 0.5));
+      juce::HeapBlock<float> block((size_t) c.blockSize);
+      for (juce::int64 rendered = 0; rendered < length; rendered += c.blockSize)
+        sequencer.renderNextBlock(block, c.blockSize);
+
+      expectEquals((int) steps.size(), c.numSteps);
+      double worst = 0.0;
+      for (size_t n = 0; n < steps.size(); ++n)
+        worst = juce::jmax(worst, std::abs((double) steps[n] - (double) n * period));
+      expect(worst <= 1.0, "a step was " + juce::String(worst) + " samples out");
+    }
+  }
+
+private:
+  /** Notes when each step is taken */
+  struct StepRecorder : public FrequencyGenerator
+  {
+    explicit StepRecorder(std::vector<juce::int64>& steps) : steps_(steps) {}
+
+    double getNextFreq() override
+    {
+      steps_.push_back(sequencer->getSamplePosition());
+      return 440.0;
+    }
+
+    Sequencer* sequencer = nullptr;
+
+  private:
+    std::vector<juce::int64>& steps_;
+  };
+};
+
+static SequencerTests sequencerTests;
+
+} // namespace BioSignals
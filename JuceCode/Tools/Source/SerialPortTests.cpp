@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    SerialPortTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <vector>
+#include "../../Source/JUCESerial/juce_serialport.h"
+#include "../../Source/SensorIngest.h"
+
+#if JUCE_LINUX
+ #include <fcntl.h>
+ #include <stdlib.h>
+ #include <unistd.h>
+#endif
+
+namespace BioSignals
+{
+
+#if JUCE_LINUX
+
+/**
+ Runs the Linux SerialPort backend against a pseudo-terminal. The test holds
+ the master end and writes what a board would, the port opens the slave at
+ a baud rate none of the Bxxx constants has, and the readings are checked as
+ they come out of SensorIngest. No hardware needed.
+ */
+class SerialPortTests : public juce::UnitTest
+{
+public:
+  SerialPortTests() : juce::UnitTest("Linux serial port on a pty", "BioSignals") {}
+
+  void runTest() override
+  {
+    beginTest("Opens the slave at a custom baud rate, once");
+    const int master = posix_openpt(O_RDWR | O_NOCTTY);
+    expect(master >= 0, "posix_openpt() failed");
+    if (master < 0)
+      return;
+    expect(grantpt(master) == 0 && unlockpt(master) == 0);
+    const juce::String slavePath(ptsname(master));
+
+    SerialPort port(slavePath, nullptr);
+    expect(port.exists(), "can't open " + slavePath);
+    if (!port.exists())
+    {
+      ::close(master);
+      return;
+    }
+    expect(port.setConfig(SerialPortConfig(250000, 8, SerialPortConfig::SERIALPORT_PARITY_NONE,
+                                           SerialPortConfig::STOPBITS_1,
+                                           SerialPortConfig::FLOWCONTROL_NONE)));
+    SerialPortConfig config;
+    expect(port.getConfig(config));
+    expectEquals((int) config.bps, 250000);
+    expect(port.setReadPolicy(SerialPortReadPolicy(SerialPortReadPolicy::READMODE_BLOCK, 0, 0, 20)));
+
+    SerialPort second(slavePath, nullptr);
+    expect(!second.exists(), "opened the same port twice");
+
+    SensorIngest ingest;
+    {
+      SerialPortInputStream stream(&port, [&ingest] (const unsigned char* data, int numBytes)
+                                          { ingest.handleBytes(data, numBytes); });
+      expect(!port.setReadPolicy(SerialPortReadPolicy()),
+             "changed the read policy under a running reader");
+
+      beginTest("Lines written to the master come out of SensorIngest");
+      writeAll(master, "We created a pulseSensor Object !\r\n1-3.25\r\n223.50\r\n");
+      // a line split across writes, and so across reads
+      writeAll(master, "61");
+      juce::Thread::sleep(50);
+      writeAll(master, ".5\r\n");
+
+      const auto events = waitForEvents(ingest, 3);
+      expectEquals((int) events.size(), 3);
+      const SensorRecord expected[] = { { 1, -3.25f, 0 }, { 2, 23.5f, 0 }, { 6, 1.5f, 0 } };
+      for (size_t idx = 0; idx < juce::jmin(events.size(), (size_t) 3); ++idx)
+      {
+        expectEquals((int) events[idx].record.sensor, (int) expected[idx].sensor);
+        expectEquals(events[idx].record.value, expected[idx].value);
+      }
+
+      beginTest("Closing the master closes the port");
+      ::close(master);
+      // the reader sees the hang up on its next poll
+      juce::Thread::sleep(200);
+    }
+    expect(!port.exists(), "the port outlived the pty");
+  }
+
+private:
+  void writeAll(int fd, const char* text)
+  {
+    const auto length = (ssize_t) strlen(text);
+    expect(::write(fd, text, (size_t) length) == length);
+  }
+
+  /** What the reader has handed ingest, once it's numEvents or a couple of seconds have gone by */
+  static std::vector<SensorEvent> waitForEvents(SensorIngest& ingest, int numEvents)
+  {
+    for (int waited = 0; waited < 2000 && ingest.getNumQueuedEvents() < numEvents; waited += 10)
+      juce::Thread::sleep(10);
+
+    std::vector<SensorEvent> events((size_t) ingest.getNumQueuedEvents());
+    events.resize((size_t) ingest.readEvents(events.data(), (int) events.size()));
+    return events;
+  }
+};
+
+static SerialPortTests serialPortTests;
+
+#endif
+
+} // namespace BioSignals
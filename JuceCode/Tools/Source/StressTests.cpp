@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    StressTests.cpp
+
+  ==============================================================================
+*/
+
+#include "StressTests.h"
+#include "../../Source/Sequencer.h"
+#include "../../Source/VoicePool.h"
+#include "../../Source/WavetableBank.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdio.h>
+#include <vector>
+
+namespace BioSignals
+{
+
+namespace
+{
+
+std::atomic<int> liveGenerators { 0 };
+std::atomic<int> playedAfterDelete { 0 };
+std::atomic<int> strayNotes { 0 };
+
+/** One of the real generators, counted in and out, checking what it plays */
+class CountedGenerator : public FrequencyGenerator
+{
+public:
+  CountedGenerator(FrequencyGenerator* inner, const std::vector<float>& notes) :
+      inner_(inner), notes_(notes)
+  {
+    ++liveGenerators;
+  }
+
+  ~CountedGenerator() override
+  {
+    alive_ = 0;
+    --liveGenerators;
+  }
+
+  double getNextFreq() override
+  {
+    // only a last resort without a sanitizer: the memory may have been reused
+    if (alive_ != aliveMagic)
+    {
+      ++playedAfterDelete;
+      return 440.0;
+    }
+
+    const double freq = inner_->getNextFreq();
+    if (std::find(notes_.begin(), notes_.end(), (float) freq) == notes_.end())
+      ++strayNotes;
+    return freq;
+  }
+
+private:
+  static constexpr juce::uint32 aliveMagic = 0x5e9e7ce5;
+
+  volatile juce::uint32 alive_ = aliveMagic;
+  std::unique_ptr<FrequencyGenerator> inner_;
+  std::vector<float> notes_;
+};
+
+class AudioThread : public juce::Thread
+{
+public:
+  AudioThread(Sequencer& sequencer, int blockSize) :
+      juce::Thread("StressAudio"), sequencer_(sequencer), blockSize_(blockSize) { }
+
+  void run() override
+  {
+    juce::HeapBlock<float> buffer((size_t) blockSize_);
+    while (!threadShouldExit())
+    {
+      sequencer_.renderNextBlock(buffer, blockSize_);
+      for (int idx = 0; idx < blockSize_; ++idx)
+        if (!std::isfinite(buffer[idx]))
+          nonFinite = true;
+      ++blocks;
+    }
+  }
+
+  std::atomic<juce::int64> blocks { 0 };
+  std::atomic<bool> nonFinite { false };
+
+private:
+  Sequencer& sequencer_;
+  const int blockSize_;
+};
+
+} // namespace
+
+bool SequencerStressTest::run() const
+{
+  liveGenerators = 0;
+  playedAfterDelete = 0;
+  strayNotes = 0;
+
+  auto bank = WavetableBank::createSaw();
+  VoicePool voices(*bank);
+  std::unique_ptr<Sequencer> sequencer(new Sequencer(voices));
+  sequencer->prepareToPlay(blockSize, sampleRate);
+  // a step every 48 samples at 48kHz, so every block plays something
+  sequencer->setTempo(60000.0);
+
+  juce::Random random(seed);
+  AudioThread audio(*sequencer, blockSize);
+  audio.startThread();
+
+  juce::int64 edits = 0;
+  const double started = juce::Time::getMillisecondCounterHiRes();
+  for (double elapsedMs = 0.0; elapsedMs < seconds * 1000.0;
+       elapsedMs = juce::Time::getMillisecondCounterHiRes() - started)
+  {
+    std::vector<float> notes((size_t) (1 + random.nextInt(16)));
+    for (auto& note : notes)
+      note = FrequencyGenerator::midiToFreq((juce::uint8) (36 + random.nextInt(61)));
+    const auto type = random.nextBool() ? SEQUENCE : RANDOM;
+    sequencer->setSequence(new CountedGenerator(constructFreqGenerator(type, notes), notes));
+    ++edits;
+
+    if (editsPerSecond > 0.0)
+    {
+      const double nextMs = (double) edits * 1000.0 / editsPerSecond;
+      if (nextMs > elapsedMs)
+        juce::Thread::sleep((int) (nextMs - elapsedMs));
+    }
+  }
+
+  audio.stopThread(-1);
+  const juce::int64 blocks = audio.blocks;
+  const double renderedSeconds = (double) blocks * blockSize / sampleRate;
+  sequencer.reset();
+
+  printf("%lld edits and %lld blocks (%.0f s of audio) in %.1f s\n",
+         (long long) edits, (long long) blocks, renderedSeconds, seconds);
+  printf("%d generators left, %d played after they were deleted, %d stray notes%s\n",
+         liveGenerators.load(), playedAfterDelete.load(), strayNotes.load(),
+         audio.nonFinite ? ", and output that wasn't finite" : "");
+
+  return liveGenerators == 0 && playedAfterDelete == 0 && strayNotes == 0
+      && !audio.nonFinite && blocks > 0;
+}
+
+} // namespace BioSignals
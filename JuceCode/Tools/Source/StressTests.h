@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    StressTests.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace BioSignals
+{
+
+/**
+ Hammers the Sequencer's hand over from the message thread to the audio
+ thread, the way dragging around in the SequenceEditor does but much harder.
+ An audio thread renders blocks flat out while the calling thread hands it
+ a new FreqSequence or FreqRandom, of a random length, editsPerSecond times
+ a second (0 for as fast as it can). The tempo is high enough that every
+ block steps a few times, so each generator gets played.
+
+ Each generator counts itself in and out, and notes whether it's asked for a
+ note by the audio thread after it's been deleted. Build with
+ -fsanitize=thread or -fsanitize=address to have every access checked too.
+
+ Returns false if a generator leaked or was freed twice, was played after
+ it was deleted, or played a note it wasn't given, or if the output wasn't
+ finite.
+ */
+struct SequencerStressTest
+{
+  double seconds = 10.0;
+  double sampleRate = 48000.0;
+  int blockSize = 64;
+  double editsPerSecond = 0.0;
+  juce::int64 seed = 1;
+
+  bool run() const;
+};
+
+} // namespace BioSignals